@@ -8,9 +8,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "img/image_cube.h"
+#include "img/image_pool.h"
 #include "geom/image_mesher.h"
 #include "gl/texture_atlas.h"
 #include "gl/gpu_clock.h"
+#include "gl/state.h"
 
 #include "platform/clock.h"
 #include "platform/context.h"
@@ -18,6 +20,8 @@
 #include "platform/scheduler.h"
 #include "platform/mouse.h"
 
+#include "gfx/frame.h"
+#include "gfx/frame_uniforms.h"
 #include "gfx/geometry.h"
 #include "gfx/mipmap.h"
 #include "gfx/ssao.h"
@@ -43,6 +47,7 @@
 #include "scene/horizon_store.h"
 
 #include "common/config.h"
+#include "common/log.h"
 
 namespace pt
 {
@@ -53,6 +58,8 @@ struct Data
     cfg::Config        config;
 
     Size<int>          renderSize;
+    gfx::FrameGraph    graph;
+    gfx::FrameUniforms frameUniforms;
 
     gfx::Geometry      geometry;
     gfx::Ssao          ssao;
@@ -86,6 +93,8 @@ struct Data
     platform::Mouse    mouse;
 
     TimePoint          lastLiveUpdate;
+    Duration           animateTime;
+    float              timeSec;
 
     ThroughputCpu      throughput;
 
@@ -93,17 +102,18 @@ struct Data
         display(display),
         config(config),
         renderSize(display->size() * config.video.output.scale),
-        geometry(renderSize),
+        graph(gfx::frame(renderSize, config.video)),
+        geometry(renderSize, graph),
         ssao(config.video.ssao.samples,
-             renderSize, renderSize * config.video.ssao.scale),
-        ssr(renderSize, renderSize * config.video.ssr.scale),
-        lighting(config.video, geometry.texDepth),
-        bloom(renderSize),
+             renderSize, renderSize * config.video.ssao.scale, graph),
+        ssr(renderSize, renderSize * config.video.ssr.scale, graph),
+        lighting(config.video, geometry.texDepth, graph),
+        bloom(renderSize, graph),
         outline(renderSize, geometry.texDepth),
         backdrop(renderSize),
         envMipmap(renderSize * config.video.env.scale, 4, true),
-        colorGrade(renderSize),
-        antiAlias(renderSize),
+        colorGrade(renderSize, graph),
+        antiAlias(renderSize, graph),
         output(display->size()),
 
         textureStore({1024, 1024}),
@@ -128,12 +138,109 @@ struct Data
         scenePane(toolsWindow.add("Scene"), display, &scene,
                   &horizonStore, &objectStore),
         objectPane(toolsWindow.add("Objects", true),
-                   display, &objectStore, &textureStore)
+                   display, &objectStore, &textureStore),
+
+        timeSec(0.f)
     {
+        // The stores are loaded, drop the decode buffers they released
+        PTLOG(Info) << "image pool: " << ImagePool::pooledBytes() / 1024
+                    << " KiB trimmed";
+        ImagePool::trim();
+
+        bindPasses();
         toolsWindow.select(1);
         display->update();
     }
 
+    void bindPasses()
+    {
+        graph.run("geom-opq", [this]
+        {
+            const gfx::Geometry::Instances chars =
+                scene.characterGeometry();
+
+            gfx::Geometry::Instances geom =
+                scene.objectGeometry(camera, Scene::GeometryType::Opaque);
+            geom.insert(geom.end(), chars.begin(), chars.end());
+
+            geometry(&textureStore.albedo.texture,
+                     &textureStore.normal.texture,
+                     &textureStore.light.texture,
+                     geom);
+        });
+        graph.run("ssao", [this]
+        {
+            ssao(&geometry.texDepthLinear, &geometry.texNormalDenoise);
+        });
+        graph.run("lighting-sc", [this]
+        {
+            lighting.sc(&geometry.texDepth,
+                        &scene.lightmap().light().second);
+        });
+        graph.run("lighting", [this]
+        {
+            lighting(&geometry.texDepth,
+                     &geometry.texNormalDenoise,
+                     &geometry.texColor,
+                     &geometry.texLight,
+                     &geometry.texProbe,
+                     &ssao.output(),
+                     &scene.lightmap().light().second,
+                     &scene.lightmap().incidence().second);
+        });
+        graph.run("env-mips", [this]
+        {
+            envMipmap(lighting.output(), &geometry.texDepth);
+        });
+        graph.run("backdrop", [this]
+        {
+            backdrop(&lighting.fboOut);
+        });
+        graph.run("ssr", [this]
+        {
+            ssr(&geometry.texDepthLinear,
+                &geometry.texNormalDenoise,
+                &geometry.texLight,
+                lighting.output(),
+                envMipmap.output(),
+                camera);
+        });
+        graph.run("geom-tr", [this]
+        {
+            geometry(
+                ssr.output(),
+                envMipmap.output(),
+                &textureStore.albedo.texture,
+                &textureStore.light.texture,
+                &scene.lightmap().light().second,
+                &scene.lightmap().incidence().second,
+                scene.objectGeometry(camera, Scene::GeometryType::Transparent));
+        });
+        graph.run("bloom", [this]
+        {
+            bloom(&geometry.texComp);
+        });
+        graph.run("scene-ctrl", [this]
+        {
+            sceneControl(&geometry.fboComp, &geometry.texComp);
+        });
+        graph.run("colorgrade", [this]
+        {
+            colorGrade(&geometry.texComp, bloom.output());
+        });
+        graph.run("anti-alias", [this]
+        {
+            antiAlias(colorGrade.output());
+        });
+        graph.run("output", [this]
+        {
+            output(antiAlias.output());
+            #if 0
+            output(&scene.lightmap().debug(&geometry.texDepth, renderSize));
+            #endif
+        });
+    }
+
     bool simulate(TimePoint time, Duration step)
     {
         // Process events
@@ -145,6 +252,9 @@ struct Data
             mouse.update(event);
         }
 
+        // NanoGUI handlers may use GL behind the state cache
+        gl::State::reset();
+
         // Read key states
         const uint8_t* keyState = SDL_GetKeyboardState(nullptr);
         if (keyState[SDL_SCANCODE_ESCAPE])
@@ -157,25 +267,30 @@ struct Data
         sceneControl(time, step, objectPane.selected());
 
         // Animate scene
-        scene.animate(time, step);
+        const Time<ChronoClock> animateStart;
+        scene.animate(time, step, camera);
+        animateTime = animateStart.elapsed();
 
         // Update object store
         if (std::chrono::duration_cast<std::chrono::milliseconds>(
             time - lastLiveUpdate).count() > 1000)
         {
-            if (objectStore.update(textureStore))
+            const int objectCount    = objectStore.update(textureStore);
+            const int characterCount = characterStore.update(textureStore);
+            if (objectCount)
                 scene.updateLightmap();
 
-            characterStore.update(textureStore);
+            // Drop the buffers of the replaced images
+            if (objectCount || characterCount)
+                ImagePool::trim();
             lastLiveUpdate = time;
         }
 
-        // Add character
+        // Add character, lit by probes rather than the bake. The item is an
+        // instance of the loaded character with a playback of its own.
         if (scene.characterGeometry().empty())
-        {
-            scene.add(CharacterItem(character, {glm::vec3(-80, 0, -48)}));
-            scene.updateLightmap();
-        }
+            scene.add(CharacterItem(character.clone(),
+                                    {glm::vec3(-80, 0, -48)}));
 
         // UI actions
         if (auto action = scenePane.nextAction())
@@ -186,107 +301,23 @@ struct Data
 
     bool render(TimePoint time, float /*a*/)
     {
-        const auto timeSec = std::chrono::duration<float>(time.time_since_epoch()).count();
+        timeSec = std::chrono::duration<float>(time.time_since_epoch()).count();
         const auto detailedStats = config.debug.detailedStats;
 
         TimeTree<GpuClock> timeTree;
         auto timeTotal = timeTree.scope("total", detailedStats);
 
-        const gfx::Geometry::Instances chars =
-            scene.characterGeometry();
+        // Upload atlas changes of the simulation steps
+        textureStore.update();
 
-        gfx::Geometry::Instances geom =
-            scene.objectGeometry(Scene::GeometryType::Opaque);
-        geom.insert(geom.end(), chars.begin(), chars.end());
+        // Camera and scene constants shared by the passes
+        frameUniforms(camera, scene.bounds(), timeSec);
 
+        // Passes in graph order, culled ones skipped
+        for (const auto& pass : graph.passes())
         {
-            auto time = timeTree.scope("geom-opq", detailedStats);
-            geometry(&textureStore.albedo.texture,
-                     &textureStore.normal.texture,
-                     &textureStore.light.texture,
-                     geom, camera);
-        }
-        {
-            auto time = timeTree.scope("ssao", detailedStats);
-            ssao(&geometry.texDepthLinear,
-                 &geometry.texNormalDenoise,
-                 camera.matrixProj(), camera.fov);
-        }
-        {
-            auto time = timeTree.scope("lighting-sc", detailedStats);
-            lighting.sc(&geometry.texDepth,
-                        &scene.lightmap().light().second,
-                        camera,
-                        scene.bounds());
-        }
-        {
-            auto time = timeTree.scope("lighting", detailedStats);
-            lighting(&geometry.texDepth,
-                     &geometry.texNormalDenoise,
-                     &geometry.texColor,
-                     &geometry.texLight,
-                     &ssao.output(),
-                     &scene.lightmap().light().second,
-                     &scene.lightmap().incidence().second,
-                     camera,
-                     scene.bounds(),
-                     timeSec);
-        }
-        {
-            auto time = timeTree.scope("env-mips", detailedStats);
-            envMipmap(lighting.output(), &geometry.texDepth);
-        }
-        {
-            auto time = timeTree.scope("backdrop", detailedStats);
-            backdrop(&lighting.fboOut, camera);
-        }
-        {
-            auto time = timeTree.scope("ssr", detailedStats);
-            ssr(&geometry.texDepthLinear,
-                &geometry.texNormalDenoise,
-                &geometry.texLight,
-                lighting.output(),
-                envMipmap.output(),
-                camera);
-        }
-        {
-            auto time = timeTree.scope("geom-tr", detailedStats);
-            geometry(
-                ssr.output(),
-                envMipmap.output(),
-                &textureStore.albedo.texture,
-                &textureStore.light.texture,
-                &scene.lightmap().light().second,
-                &scene.lightmap().incidence().second,
-                scene.bounds(),
-                scene.objectGeometry(Scene::GeometryType::Transparent),
-                camera);
-        }
-        {
-            auto time = timeTree.scope("bloom", detailedStats);
-            bloom(&geometry.texComp);
-        }
-        {
-            auto time = timeTree.scope("scene-ctrl", detailedStats);
-            sceneControl(&geometry.fboComp, &geometry.texComp);
-        }
-        {
-            auto time = timeTree.scope("colorgrade", detailedStats);
-            colorGrade(&geometry.texComp, bloom.output());
-        }
-        {
-            auto time = timeTree.scope("anti-alias", detailedStats);
-            antiAlias(colorGrade.output());
-        }
-        {
-            auto time = timeTree.scope("output", detailedStats);
-            output(antiAlias.output());
-            #if 0
-            output(&scene.lightmap().debug(&geometry.texDepth,
-                                           renderSize,
-                                           camera,
-                                           scene.bounds()));
-            #endif
+            auto time = timeTree.scope(pass, detailedStats);
+            graph(pass);
         }
         {
             auto time = timeTree.scope("ui", detailedStats);
@@ -296,7 +327,12 @@ struct Data
         timeTotal.end();
 
         stats.accumulate(timeTree);
-        stats(throughput(), scene.cellResolution());
+        stats.accumulate("animate", animateTime);
+        stats(throughput(), scene.cellResolution(), gl::State::counts());
+        gl::State::resetCounts();
+
+        // NanoVG drew the widgets and stats behind the state cache
+        gl::State::reset();
 
         fader(1.f - timeSec);
 
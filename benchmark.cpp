@@ -0,0 +1,699 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <boost/algorithm/string/replace.hpp>
+
+#include <ozz/base/memory/allocator.h>
+
+#include "platform/clock.h"
+#include "common/config.h"
+#include "common/file_system.h"
+#include "common/metadata.h"
+#include "common/log.h"
+#include "geom/image_mesher.h"
+#include "geom/mesh_deformer.h"
+#include "geom/mesh_optimizer.h"
+#include "geom/occupancy.h"
+#include "gfx/frame.h"
+#include "img/block_codec.h"
+#include "img/image_atlas.h"
+#include "img/image_cube.h"
+#include "img/image_kernels.h"
+#include "img/image_pool.h"
+#include "scene/animation.h"
+#include "constants.h"
+
+namespace pt
+{
+
+namespace
+{
+
+constexpr int REPEATS = 5;
+
+// Fastest of repeated runs, in milliseconds
+template <typename F>
+float bestOf(int repeats, F f)
+{
+    float best = std::numeric_limits<float>::max();
+    for (int i = 0; i < repeats; ++i)
+    {
+        const Time<ChronoClock> time;
+        f();
+        best = std::min(best, std::chrono::duration<float, std::milli>
+                              (time.elapsed()).count());
+    }
+    return best;
+}
+
+// Counts the bytes ozz allocates while in scope
+struct CountingAllocator : ozz::memory::Allocator
+{
+    CountingAllocator() :
+        base(ozz::memory::SetDefaulAllocator(this)), bytes(0)
+    {}
+
+    ~CountingAllocator()
+    {
+        ozz::memory::SetDefaulAllocator(base);
+    }
+
+    void* Allocate(size_t size, size_t alignment) override
+    {
+        bytes += size;
+        return base->Allocate(size, alignment);
+    }
+
+    void Deallocate(void* block) override
+    {
+        base->Deallocate(block);
+    }
+
+    void* Reallocate(void* block, size_t size, size_t alignment) override
+    {
+        bytes += size;
+        return base->Reallocate(block, size, alignment);
+    }
+
+    ozz::memory::Allocator* base;
+    std::size_t             bytes;
+};
+
+// Object directories below the root, in path order
+std::vector<fs::path> objectPaths(const fs::path& root)
+{
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::recursive_directory_iterator(root))
+        if (fs::is_directory(entry) &&
+            fs::exists(entry.path() / c::object::METAFILE))
+            paths.push_back(entry.path());
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Geometry settings of an object, as read by Object
+geom::Meta geomMeta(const fs::path& path)
+{
+    return geom::Meta::parse(readJson(path / c::object::METAFILE));
+}
+
+void mesher()
+{
+    float totalOccupancy = 0.f, totalScan = 0.f, totalMesh = 0.f;
+    std::size_t totalTriangles = 0;
+    int mismatches = 0;
+
+    // The binary mesher emits the quads of the scan, in the same order
+    const auto equal = [](const Mesh_P_N_T_UV& a, const Mesh_P_N_T_UV& b)
+    {
+        return a.vertices.size() == b.vertices.size() &&
+               a.indices.size()  == b.indices.size()  &&
+               !std::memcmp(a.vertices.data(), b.vertices.data(),
+                            a.vertices.size() * sizeof(a.vertices[0])) &&
+               !std::memcmp(a.indices.data(), b.indices.data(),
+                            a.indices.size() * sizeof(a.indices[0]));
+    };
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        const auto geom = geomMeta(path);
+
+        const ImageCube depth((path / "*.png").generic_string(), 1);
+        Occupancy occupancy;
+        Mesh_P_N_T_UV scan, mesh;
+
+        const float tOccupancy = bestOf(REPEATS, [&]()
+        {occupancy = Occupancy(depth);});
+        const float tScan      = bestOf(REPEATS, [&]()
+        {scan = ImageMesher::boxFacesScan(occupancy, RectCube<float>(),
+                                          geom.scale, !geom.smooth);});
+        const float tMesh      = bestOf(REPEATS, [&]()
+        {mesh = ImageMesher::boxFaces(occupancy, RectCube<float>(),
+                                      geom.scale, !geom.smooth);});
+        mismatches += !equal(scan, mesh);
+
+        PTLOG(Info) << path.generic_string() << " "
+                    << occupancy.width  << "x"
+                    << occupancy.height << "x"
+                    << occupancy.depth  << ": "
+                    << mesh.triangleCount() << " triangles, occupancy "
+                    << tOccupancy << " ms, scan " << tScan
+                    << " ms, mesh " << tMesh << " ms";
+
+        totalOccupancy += tOccupancy;
+        totalScan      += tScan;
+        totalMesh      += tMesh;
+        totalTriangles += mesh.triangleCount();
+    }
+    PTLOG(Info) << "mesher total: " << totalTriangles << " triangles, "
+                << "occupancy " << totalOccupancy << " ms, "
+                << "scan " << totalScan << " ms, "
+                << "mesh " << totalMesh << " ms, "
+                << mismatches << " mismatching meshes";
+}
+
+// Threshold iterations against the priority queue, with the queue
+// targeting the triangle count the iterations arrive at
+void simplifier()
+{
+    float totalIterations = 0.f, totalQueue = 0.f;
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        const auto geom = geomMeta(path);
+        if (!geom.smooth || geom.simplify.queued())
+            continue;
+
+        const ImageCube depth((path / "*.png").generic_string(), 1);
+        const Occupancy occupancy(depth);
+        const auto size = geom.scale * occupancy.size();
+        const auto mesh = MeshDeformer::smooth(
+                          ImageMesher::boxFaces(occupancy, RectCube<float>(),
+                                                geom.scale, false),
+                          geom.smooth);
+
+        Mesh_P_N_T_UV meshIterations, meshQueue;
+        const float tIterations = bestOf(REPEATS, [&]()
+        {meshIterations = MeshDeformer::decimate(mesh, RectCube<float>(), size,
+                                                 geom.simplify);});
+
+        auto queued   = geom.simplify;
+        queued.target = float(meshIterations.triangleCount()) /
+                        std::max(1, mesh.triangleCount());
+        const float tQueue = bestOf(REPEATS, [&]()
+        {meshQueue = MeshDeformer::decimate(mesh, RectCube<float>(), size,
+                                            queued);});
+
+        PTLOG(Info) << path.generic_string() << ": "
+                    << mesh.triangleCount() << " triangles, iterations "
+                    << meshIterations.triangleCount() << " in "
+                    << tIterations << " ms, queue "
+                    << meshQueue.triangleCount() << " in "
+                    << tQueue << " ms";
+
+        totalIterations += tIterations;
+        totalQueue      += tQueue;
+    }
+    PTLOG(Info) << "simplifier total: iterations " << totalIterations
+                << " ms, queue " << totalQueue << " ms";
+}
+
+// Vertex counts and cache efficiency of the final object meshes against
+// the triangle soups they used to be uploaded as
+void vertexCache()
+{
+    // Cube sides side by side, so UV seams stay seams
+    RectCube<float> uvCube;
+    for (int i = 0; i < int(uvCube.size()); ++i)
+        uvCube[i] = Rect<float>(i / 6.f, 0.f, 1.f / 6.f, 1.f);
+
+    std::size_t totalSoup = 0, totalIndexed = 0;
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        const auto geom = geomMeta(path);
+        const ImageCube depth((path / "*.png").generic_string(), 1);
+        const auto mesh = ImageMesher::mesh(Occupancy(depth), uvCube, geom);
+
+        Mesh_P_N_T_UV soup;
+        for (const auto i : mesh.indices)
+        {
+            soup.indices.push_back(Mesh_P_N_T_UV::Index(soup.vertices.size()));
+            soup.vertices.push_back(mesh.vertices[i]);
+        }
+
+        PTLOG(Info) << path.generic_string() << ": "
+                    << mesh.triangleCount() << " triangles, vertices "
+                    << soup.vertices.size() << " -> " << mesh.vertices.size()
+                    << ", ACMR " << MeshOptimizer::acmr(soup)
+                    << " -> "    << MeshOptimizer::acmr(mesh);
+
+        totalSoup    += soup.vertices.size();
+        totalIndexed += mesh.vertices.size();
+    }
+    PTLOG(Info) << "vertex cache total: vertices " << totalSoup
+                << " -> " << totalIndexed;
+}
+
+// Smooth objects meshed by greedy box faces, smoothing and decimation
+// against surface nets and decimation
+void surfaceNets()
+{
+    float totalGreedy = 0.f, totalNets = 0.f;
+    std::size_t trianglesGreedy = 0, trianglesNets = 0;
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        auto geom = geomMeta(path);
+        if (!geom.smooth)
+            continue;
+
+        const ImageCube depth((path / "*.png").generic_string(), 1);
+        const Occupancy occupancy(depth);
+
+        Mesh_P_N_T_UV meshGreedy, meshNets;
+        geom.mesher = geom::Mesher::Greedy;
+        const float tGreedy = bestOf(REPEATS, [&]()
+        {meshGreedy = ImageMesher::mesh(occupancy, RectCube<float>(), geom);});
+
+        geom.mesher = geom::Mesher::SurfaceNets;
+        const float tNets   = bestOf(REPEATS, [&]()
+        {meshNets = ImageMesher::mesh(occupancy, RectCube<float>(), geom);});
+
+        PTLOG(Info) << path.generic_string() << ": greedy "
+                    << meshGreedy.triangleCount() << " triangles in "
+                    << tGreedy << " ms, surface nets "
+                    << meshNets.triangleCount() << " triangles in "
+                    << tNets << " ms";
+
+        totalGreedy     += tGreedy;
+        totalNets       += tNets;
+        trianglesGreedy += meshGreedy.triangleCount();
+        trianglesNets   += meshNets.triangleCount();
+    }
+    PTLOG(Info) << "surface nets total: greedy " << trianglesGreedy
+                << " triangles in " << totalGreedy << " ms, surface nets "
+                << trianglesNets << " triangles in " << totalNets << " ms";
+}
+
+// Atlas packing of the object albedo cubes: filling an atlas of the
+// texture store size, churning entries as hot reloads do, then
+// defragmenting
+void atlas()
+{
+    const Size<int> size(1024, 1024);
+    const int margin = 2;
+    const int churns = 1000;
+
+    std::vector<ImageCube> cubes;
+    for (const auto& path : objectPaths("objects"))
+        cubes.emplace_back((path / "albedo.*.png").generic_string(), 4);
+    if (cubes.empty())
+        return;
+
+    // Fill until the first cube fails to fit
+    ImageAtlas atlas(size);
+    std::vector<std::pair<int, RectCube<int>>> entries;
+    const Time<ChronoClock> fillTime;
+    for (int i = 0;; ++i)
+    {
+        const int c = i % int(cubes.size());
+        const auto rects = atlas.insert(cubes[c], margin);
+        if (std::any_of(rects.begin(), rects.end(),
+                        [](const Rect<int>& r) {return !r.size;}))
+        {
+            for (const auto& rect : rects)
+                atlas.remove(rect);
+            break;
+        }
+        entries.emplace_back(c, rects);
+    }
+    const float tFill = std::chrono::duration<float, std::milli>
+                        (fillTime.elapsed()).count();
+    const float occupancyFill = atlas.occupancy();
+    const auto  fillCount     = entries.size();
+
+    // Replace random entries with random cubes
+    std::mt19937 random(1);
+    int failures = 0;
+    const Time<ChronoClock> churnTime;
+    for (int i = 0; i < churns && !entries.empty(); ++i)
+    {
+        auto& entry = entries[random() % entries.size()];
+        for (const auto& rect : entry.second)
+            atlas.remove(rect);
+
+        entry.first  = int(random() % cubes.size());
+        entry.second = atlas.insert(cubes[entry.first], margin);
+        if (std::any_of(entry.second.begin(), entry.second.end(),
+                        [](const Rect<int>& r) {return !r.size;}))
+        {
+            for (const auto& rect : entry.second)
+                atlas.remove(rect);
+            entry = entries.back();
+            entries.pop_back();
+            ++failures;
+        }
+    }
+    const float tChurn = std::chrono::duration<float, std::milli>
+                         (churnTime.elapsed()).count();
+    const float occupancyChurn = atlas.occupancy();
+
+    ImageAtlas::Remap remap;
+    const float tDefragment = bestOf(1, [&]() {remap = atlas.defragment();});
+
+    // Cubes fitting after defragmenting
+    int refills = 0;
+    for (int i = 0;; ++i)
+    {
+        const auto rects = atlas.insert(cubes[i % int(cubes.size())], margin);
+        if (std::any_of(rects.begin(), rects.end(),
+                        [](const Rect<int>& r) {return !r.size;}))
+            break;
+        ++refills;
+    }
+
+    PTLOG(Info) << "atlas fill: " << fillCount << " cubes, "
+                << 100.f * occupancyFill << "% in " << tFill << " ms";
+    PTLOG(Info) << "atlas churn: " << churns << " reloads, " << failures
+                << " failed, " << 100.f * occupancyChurn << "% in "
+                << tChurn << " ms";
+    PTLOG(Info) << "atlas defragment: " << remap.size() << " rects in "
+                << tDefragment << " ms, " << refills
+                << " more cubes fit, " << 100.f * atlas.occupancy() << "%";
+}
+
+// Block compression of the object cubes as the atlases store them:
+// albedo and light in BC3, normals in BC5
+void blocks()
+{
+    using BlockCodec::Format;
+    const struct {const char* pattern; int depth; Format format;} cubes[] =
+    {
+        {"albedo.*.png", 4, Format::BC3},
+        {"light.*.png",  4, Format::BC3},
+        {"normal.*.png", 1, Format::BC5}
+    };
+    const char* names[] = {"", "BC1", "BC3", "BC5"};
+
+    struct Total
+    {
+        double pixels = 0.0, error = 0.0, ms = 0.0;
+        float  psnrMin = std::numeric_limits<float>::max();
+    }
+    totals[4];
+
+    for (const auto& path : objectPaths("objects"))
+        for (const auto& cube : cubes)
+        {
+            ImageCube imageCube((path / cube.pattern).generic_string(),
+                                cube.depth);
+            if (cube.format == Format::BC5)
+                imageCube = imageCube.normals();
+
+            auto& total = totals[int(cube.format)];
+            for (const auto& image : imageCube.sides)
+            {
+                if (!image)
+                    continue;
+
+                std::vector<uint8_t> blocks;
+                const float t = bestOf(REPEATS, [&]()
+                {blocks = BlockCodec::encode(image, cube.format);});
+
+                const auto decoded = BlockCodec::decode(blocks.data(),
+                                                        cube.format,
+                                                        image.size());
+                const float psnr   = BlockCodec::psnr(image, decoded,
+                                                      cube.format);
+
+                // Accumulate squared error to average PSNR over pixels
+                const double mse = 255.0 * 255.0 / std::pow(10.0, psnr / 10.0);
+                total.pixels  += image.size().area();
+                total.error   += mse * image.size().area();
+                total.ms      += t;
+                total.psnrMin  = std::min(total.psnrMin, psnr);
+            }
+        }
+
+    for (const auto format : {Format::BC1, Format::BC3, Format::BC5})
+    {
+        const auto& total = totals[int(format)];
+        if (total.pixels <= 0.0)
+            continue;
+
+        const double mse = total.error / total.pixels;
+        PTLOG(Info) << names[int(format)] << ": "
+                    << total.pixels / 1e6 << " Mpixels, PSNR "
+                    << (mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) :
+                                    std::numeric_limits<double>::infinity())
+                    << " dB (min " << total.psnrMin << " dB), "
+                    << total.pixels / 1e3 / std::max(total.ms, 1e-3)
+                    << " Mpixels/s";
+    }
+}
+
+// Object cube decoding, concurrent with flipping on decode against
+// sequential decoding followed by a flipping pass
+void decode()
+{
+    const char* sides[] = {"front", "back", "left", "right", "top", "bottom"};
+    const struct {const char* pattern; int depth;} cubes[] =
+    {
+        {"*.png",        1},
+        {"albedo.*.png", 4},
+        {"light.*.png",  4},
+        {"normal.*.png", 1}
+    };
+
+    float totalSequential = 0.f, totalConcurrent = 0.f;
+    std::size_t totalBytes = 0;
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        std::size_t bytes = 0;
+        const float tSequential = bestOf(REPEATS, [&]()
+        {
+            bytes = 0;
+            for (const auto& cube : cubes)
+                for (int i = 0; i < 6; ++i)
+                {
+                    const auto fn = boost::replace_all_copy(
+                        (path / cube.pattern).generic_string(), "*", sides[i]);
+                    if (!fs::exists(fn))
+                        continue;
+
+                    const auto image = i < 4 ?
+                        Image(fn, cube.depth).flipped(Image::Axis::X) :
+                        Image(fn, cube.depth);
+                    bytes += std::size_t(image.size().h) * image.stride();
+                }
+        });
+        const float tConcurrent = bestOf(REPEATS, [&]()
+        {
+            for (const auto& cube : cubes)
+                ImageCube((path / cube.pattern).generic_string(),
+                          cube.depth, false);
+        });
+
+        PTLOG(Info) << path.generic_string() << ": " << bytes / 1024
+                    << " KiB, sequential " << tSequential
+                    << " ms, concurrent " << tConcurrent << " ms";
+
+        totalSequential += tSequential;
+        totalConcurrent += tConcurrent;
+        totalBytes      += bytes;
+    }
+
+    const auto mbs = [&](float ms)
+    {return ms > 0.f ? totalBytes / (1024.f * 1024.f) / (ms / 1000.f) : 0.f;};
+
+    PTLOG(Info) << "decode total: " << totalBytes / (1024 * 1024) << " MiB, "
+                << "sequential " << totalSequential << " ms ("
+                << mbs(totalSequential) << " MiB/s), concurrent "
+                << totalConcurrent << " ms (" << mbs(totalConcurrent)
+                << " MiB/s)";
+}
+
+// Scalar image kernels against their vectorized versions on the object
+// normal and albedo cubes, with the outputs compared bit for bit
+void image()
+{
+    using ImageKernels::Path;
+
+    float totalScalar = 0.f, totalVector = 0.f;
+    int mismatches = 0;
+
+    for (const auto& path : objectPaths("objects"))
+    {
+        const ImageCube normal((path / "normal.*.png").generic_string(), 1);
+        const ImageCube albedo((path / "albedo.*.png").generic_string(), 4);
+
+        std::vector<Image> sources;
+        for (const auto& image : normal.sides) sources.push_back(image);
+        for (const auto& image : albedo.sides) sources.push_back(image);
+
+        float tScalar = 0.f, tVector = 0.f;
+        for (const auto& src : sources)
+        {
+            if (!src)
+                continue;
+
+            const auto size  = src.size();
+            const auto depth = src.depth();
+            Image scalar(size, 4), vector(size, 4);
+
+            const auto run = [&](Path p, Image& dst)
+            {
+                if (depth == 1)
+                    ImageKernels::normals(src.bits(), src.stride(),
+                                          size.w, size.h, 1.f,
+                                          dst.bits(), dst.stride(), p);
+                else
+                    ImageKernels::maxToAlpha(src.bits(), src.stride(),
+                                             size.w, size.h,
+                                             dst.bits(), dst.stride(), p);
+            };
+            const auto flip = [&](Path p, Image& dst)
+            {
+                ImageKernels::flipRows(src.bits(), src.stride(),
+                                       size.w, size.h, depth,
+                                       dst.bits(), dst.stride(), p);
+            };
+            const auto equal = [&](const Image& a, const Image& b)
+            {
+                for (int y = 0; y < size.h; ++y)
+                    if (std::memcmp(a.bits(0, y), b.bits(0, y),
+                                    std::size_t(size.w) * a.depth()))
+                        return false;
+                return true;
+            };
+
+            tScalar += bestOf(REPEATS, [&]() {run(Path::Scalar, scalar);});
+            tVector += bestOf(REPEATS, [&]() {run(Path::Vector, vector);});
+            mismatches += !equal(scalar, vector);
+
+            Image flipScalar(size, depth), flipVector(size, depth);
+            tScalar += bestOf(REPEATS, [&]() {flip(Path::Scalar, flipScalar);});
+            tVector += bestOf(REPEATS, [&]() {flip(Path::Vector, flipVector);});
+            mismatches += !equal(flipScalar, flipVector);
+        }
+
+        PTLOG(Info) << path.generic_string() << ": scalar " << tScalar
+                    << " ms, " << ImageKernels::vectorIsa() << " "
+                    << tVector << " ms";
+
+        totalScalar += tScalar;
+        totalVector += tVector;
+    }
+    PTLOG(Info) << "image total: scalar " << totalScalar << " ms, "
+                << ImageKernels::vectorIsa() << " " << totalVector
+                << " ms, " << mismatches << " mismatching images, "
+                << ImagePool::pooledBytes() / 1024 << " KiB pooled";
+    ImagePool::trim();
+}
+
+// Memory and sampling time of a crowd of playbacks sharing one skeleton
+// and clip set, against loading the animation per character, sampled
+// sequentially and in parallel
+void animation()
+{
+    const int instances = 1000;
+    const auto meta     = readJson(fs::path("characters") / "male1" /
+                                   c::character::METAFILE);
+    const fs::path root = meta["animation_root"].get<std::string>();
+
+    CountingAllocator allocator;
+    const Animation animation(root, meta);
+    const auto sharedBytes = allocator.bytes;
+    if (!animation)
+        return;
+
+    // Random clips and phases
+    allocator.bytes  = 0;
+    const auto clips = animation.clips();
+    std::mt19937 random(1);
+    std::vector<AnimationPlayback> crowd;
+    for (int i = 0; i < instances; ++i)
+        crowd.push_back(AnimationPlayback(animation).
+                        activate(clips[random() % clips.size()],
+                                 std::chrono::milliseconds(random() % 1000)));
+    const auto instanceBytes = allocator.bytes / instances;
+
+    // Frames of the whole crowd
+    TimePoint time;
+    const float tAnimate = bestOf(REPEATS, [&]()
+    {
+        time += std::chrono::milliseconds(16);
+        for (auto& playback : crowd)
+            playback.animate(time, Duration(0));
+    });
+    const float tParallel = bestOf(REPEATS, [&]()
+    {
+        time += std::chrono::milliseconds(16);
+        #pragma omp parallel for
+        for (int i = 0; i < instances; ++i)
+            crowd[i].animate(time, Duration(0));
+    });
+
+    const auto sharedTotal = sharedBytes + instances * instanceBytes;
+    const auto loadedTotal = instances * (sharedBytes + instanceBytes);
+    PTLOG(Info) << "animation: " << animation.jointCount() << " joints, "
+                << clips.size() << " clips, " << sharedBytes / 1024
+                << " KiB shared, " << instanceBytes << " bytes per instance";
+    PTLOG(Info) << "animation crowd of " << instances << ": "
+                << sharedTotal / 1024 << " KiB shared against "
+                << loadedTotal / 1024 << " KiB loaded per character, "
+                << tAnimate << " ms per frame, " << tParallel
+                << " ms in parallel";
+}
+
+// Render target memory of the frame at each video preset, every target in
+// its own texture against targets of disjoint lifetimes sharing one
+void frameGraph()
+{
+    const Size<int> size(1920, 1080);
+    const std::pair<const char*, cfg::Video> presets[] =
+    {
+        {"ultra", cfg::preset::ULTRA},
+        {"high",  cfg::preset::HIGH},
+        {"low",   cfg::preset::LOW}
+    };
+    for (const auto& preset : presets)
+    {
+        auto config        = preset.second;
+        config.output.size = glm::vec2(size.w, size.h);
+        const auto graph   = gfx::frame(size, config);
+
+        PTLOG(Info) << "framegraph " << preset.first << " at "
+                    << size.w << "x" << size.h << ": "
+                    << graph.passes().size() << " passes, "
+                    << graph.culled().size() << " culled, "
+                    << graph.targetCount() << " targets in "
+                    << graph.textureCount() << " textures, "
+                    << graph.targetBytes() / (1 << 20) << " MiB -> "
+                    << graph.textureBytes() / (1 << 20) << " MiB";
+    }
+}
+
+const std::map<std::string, std::function<void()>> benchmarks =
+{
+    {"animation",   animation},
+    {"atlas",       atlas},
+    {"blocks",      blocks},
+    {"decode",      decode},
+    {"framegraph",  frameGraph},
+    {"image",       image},
+    {"mesher",      mesher},
+    {"simplifier",  simplifier},
+    {"surfacenets", surfaceNets},
+    {"vertexcache", vertexCache}
+};
+
+} // namespace
+
+bool Benchmark::run(const boost::program_options::variables_map& args)
+{
+    const auto name = args["benchmark"].as<std::string>();
+    const auto it   = benchmarks.find(name);
+    if (it == benchmarks.end())
+    {
+        PTLOG(Error) << "Unknown benchmark: " << name;
+        return false;
+    }
+
+    PTTIMEU("benchmark " + name, std::milli);
+    it->second();
+    return true;
+}
+
+} // namespace pt
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <boost/program_options.hpp>
+
+namespace pt
+{
+
+// Headless timings of the asset pipeline over the shipped assets
+struct Benchmark
+{
+    Benchmark() = default;
+
+    bool run(const boost::program_options::variables_map& args);
+};
+
+} // namespace pt
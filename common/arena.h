@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace pt
+{
+
+// Bump allocator for trivially destructible scratch data. Memory is kept
+// over resets and coalesced into a single block, so repeated use of the
+// same arena settles into one allocation.
+struct Arena
+{
+    explicit Arena(std::size_t blockSize = 1 << 20) :
+        blockSize(blockSize), used(0)
+    {}
+
+    template <typename T>
+    T* alloc(std::size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena types must be trivially destructible");
+        return static_cast<T*>(alloc(count * sizeof(T), alignof(T)));
+    }
+
+    void* alloc(std::size_t size, std::size_t align)
+    {
+        if (!blocks.empty())
+        {
+            auto& block = blocks.back();
+            const auto offset = (used + align - 1) & ~(align - 1);
+            if (offset + size <= block.size)
+            {
+                used = offset + size;
+                return block.data.get() + offset;
+            }
+        }
+        const auto newSize = std::max(blockSize, size + align);
+        blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[newSize]),
+                          newSize});
+        used = 0;
+        return alloc(size, align);
+    }
+
+    Arena& reset()
+    {
+        if (blocks.size() > 1)
+        {
+            std::size_t size = 0;
+            for (const auto& block : blocks)
+                size += block.size;
+
+            blocks.clear();
+            blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]),
+                              size});
+        }
+        used = 0;
+        return *this;
+    }
+
+    std::size_t capacity() const
+    {
+        std::size_t size = 0;
+        for (const auto& block : blocks)
+            size += block.size;
+        return size;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t                size;
+    };
+
+    std::size_t        blockSize;
+    std::size_t        used;
+    std::vector<Block> blocks;
+};
+
+} // namespace pt
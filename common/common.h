@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include <cmath>
+#include <cstdint>
 #include <gsl-lite.hpp>
 
 #include "file_system.h"
@@ -67,6 +68,29 @@ inline D bitCast(const S& src)
     return dst;
 }
 
+inline int popcount(uint64_t v)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+    #else
+    int n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+    #endif
+}
+
+// Index of the lowest set bit, undefined for zero
+inline int ctz(uint64_t v)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+    #else
+    int n = 0;
+    for (; !(v & 1); v >>= 1) ++n;
+    return n;
+    #endif
+}
+
 inline int umod(int x, int y)
 {
     return ((x < 0) ? ((x % y) + y) : x) % y;
@@ -41,6 +41,7 @@ namespace object
         constexpr auto BASE     = "base",
                        ORIGIN   = "origin",
                        SCALE    = "scale",
+                       MESHER   = "mesher",
                        PULSE    = "pulse",
                        SMOOTH   = "smooth",
                        SIMPLIFY = "simplify",
@@ -53,6 +54,15 @@ namespace object
     }
 }
 
+namespace model
+{
+    // Levels of detail, finest first. A coarser level is used once the
+    // projected radius drops below its fraction of the half screen height.
+    constexpr auto LOD_COUNT    = 3;
+    constexpr auto LOD_TARGET   = 0.35f; // Triangles kept per level
+    constexpr float LOD_SIZES[LOD_COUNT - 1] = {0.1f, 0.03f};
+}
+
 namespace character
 {
     constexpr auto METAFILE = "character.json";
@@ -61,6 +71,17 @@ namespace character
     {
         constexpr auto SCALE = 28.125f;
     }
+
+    // Animation rates, in steps between updates. A character is animated
+    // less often once its projected radius drops below a fraction of the
+    // half screen height, and least often off screen.
+    namespace animation
+    {
+        constexpr auto  LOD_COUNT                = 3;
+        constexpr int   LOD_STEPS[LOD_COUNT]     = {1, 2, 4};
+        constexpr float LOD_SIZES[LOD_COUNT - 1] = {0.05f, 0.02f};
+        constexpr auto  OFFSCREEN_STEPS          = 8;
+    }
 }
 
 } // namespace c
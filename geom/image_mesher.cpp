@@ -1,11 +1,15 @@
 #include "image_mesher.h"
 
 #include <array>
+#include <algorithm>
+#include <vector>
 
 #include <glm/ext.hpp>
 #include <glm/gtx/hash.hpp>
 
 #include "platform/clock.h"
+#include "common/arena.h"
+#include "common/common.h"
 #include "common/log.h"
 
 #include "volume.h"
@@ -13,6 +17,8 @@
 
 #include "mesh_common.h"
 #include "mesh_deformer.h"
+#include "mesh_optimizer.h"
+#include "sn_mesher.h"
 
 namespace pt
 {
@@ -72,17 +78,297 @@ void collapseConstants(int cc[8][3], int g)
     std::copy(&c[0][0], &c[0][0] + 8 * 3, &cc[0][0]);
 }
 
+using Word = Occupancy::Word;
+constexpr int WORD_BITS = Occupancy::WORD_BITS;
+
+// Scratch memory of the mesher, reused across models
+thread_local Arena arena;
+
+struct Cell
+{
+    int v, g;
+};
+
+// Voxel values and gradients. Volumes that compute them per query are
+// cached in the arena, laid out as [z][y][x].
+template <typename V>
+struct Voxels
+{
+    Voxels(const V& vol, Arena& arena) :
+        width(vol.width), height(vol.height), depth(vol.depth),
+        cells(arena.alloc<Cell>(std::size_t(width) * height * depth))
+    {
+        for (int z = 0, i = 0; z < depth; ++z)
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x, ++i)
+                {
+                    const int v = vol(x, y, z);
+                    cells[i] = {v, v ? vol.g(x, y, z) : 0};
+                }
+    }
+
+    inline Cell operator()(int x, int y, int z) const
+    {
+        return x >= 0 && y >= 0 && z >= 0 &&
+               x < width && y < height && z < depth ?
+               cells[(z * height + y) * width + x] : Cell {0, 0};
+    }
+
+    int   width, height, depth;
+    Cell* cells;
+};
+
+template <>
+struct Voxels<Occupancy>
+{
+    Voxels(const Occupancy& vol, Arena&) : vol(vol)
+    {}
+
+    inline Cell operator()(int x, int y, int z) const
+    {
+        return vol(x, y, z) ? Cell {1, vol.g(x, y, z)} : Cell {0, 0};
+    }
+
+    const Occupancy& vol;
+};
+
+// Boundary between two cells of a slice at index n. The key packs the
+// gradients of both cells and whether the boundary goes solid to empty (0),
+// empty to solid (1) or between solids of differing gradients (2). Faces
+// with equal keys merge into the same quad.
+struct Face
+{
+    uint64_t key;
+    int      n;
+
+    bool operator<(const Face& face) const
+    {
+        return key < face.key || (key == face.key && n < face.n);
+    }
+};
+
+inline bool faceKey(const Cell& c0, const Cell& c1, uint64_t& key)
+{
+    if (c0.v && c1.v ? c0.g == c1.g : c0.v == c1.v)
+        return false;
+
+    const uint64_t kind = c0.v && c1.v ? 2 : c0.v ? 0 : 1;
+    key = uint64_t(uint32_t(c0.g)) << 34 | uint64_t(uint32_t(c1.g)) << 2 | kind;
+    return true;
+}
+
+struct Quad
+{
+    int n, w, h;
+    int d, g; // Direction along the slice axis, collapse gradient
+
+    bool operator<(const Quad& quad) const
+    {
+        return n < quad.n;
+    }
+};
+
+// Bit mask of [i, i + n) within a word, n > 0
+inline Word spanMask(int i, int n)
+{
+    return (n == WORD_BITS ? ~Word(0) : (Word(1) << n) - 1) << i;
+}
+
+// Applies f to the masked words of a row covering [i, i + w), stopping
+// early when f returns false
+template <typename F>
+inline bool forSpan(Word* row, int i, int w, F f)
+{
+    for (const int end = i + w; i < end;)
+    {
+        const int b = i % WORD_BITS;
+        const int n = std::min(end - i, WORD_BITS - b);
+        if (!f(row[i / WORD_BITS], spanMask(b, n)))
+            return false;
+        i += n;
+    }
+    return true;
+}
+
+// Number of consecutive set bits of a row starting at i
+inline int runLength(const Word* row, int stride, int i)
+{
+    int w = 0;
+    for (int k = i / WORD_BITS, b = i % WORD_BITS; k < stride; ++k, b = 0)
+    {
+        const Word bits  = ~(row[k] >> b);
+        const int  avail = WORD_BITS - b;
+        const int  n     = bits ? std::min(ctz(bits), avail) : avail;
+        w += n;
+        if (n < avail)
+            break;
+    }
+    return w;
+}
+
+// Merges the faces of a single key into quads in scan order. Rows hold a bit
+// per face along u and are left cleared.
+int mergeFaces(const Face* begin, const Face* end, Word* rows,
+               int stride, int du, int dv, bool greedy, Quad* quads)
+{
+    for (auto f = begin; f != end; ++f)
+    {
+        const int i = f->n % du;
+        rows[(f->n / du) * stride + i / WORD_BITS] |= Word(1) << (i % WORD_BITS);
+    }
+
+    const auto key = begin->key;
+    const int  g0  = int(key >> 34);
+    const int  g1  = int((key >> 2) & 0xffffffff);
+    const int  d   = (key & 3) == 0 ? 1 : (key & 3) == 1 ? -1 : g1 - g0;
+    const int  g   = d > 0 ? g0 : g1;
+
+    int quadCount = 0;
+    int remaining = int(end - begin);
+    for (int j = begin->n / du; remaining; ++j)
+    {
+        Word* row = rows + j * stride;
+        for (int k = 0; k < stride; ++k)
+            while (row[k])
+            {
+                const int i = k * WORD_BITS + ctz(row[k]);
+
+                // Widest run, then as many rows as fully cover it
+                int w = 1, h = 1;
+                if (greedy)
+                {
+                    w = runLength(row, stride, i);
+                    while (j + h < dv &&
+                           forSpan(row + h * stride, i, w,
+                                   [](Word r, Word m) {return (r & m) == m;}))
+                        ++h;
+                }
+                for (int l = 0; l < h; ++l)
+                    forSpan(row + l * stride, i, w,
+                            [](Word& r, Word m) {r &= ~m; return true;});
+
+                quads[quadCount++] = {j * du + i, w, h, d, g};
+                remaining -= w * h;
+            }
+    }
+    return quadCount;
+}
+
 template <typename V>
 Mesh_P_N_T_UV meshGreedy(const V& vol,
                          const RectCube<float>& uvCube,
                          float scale = 1.f,
                          bool greedy = true)
 {
-    struct Cell
+    // Dimensions
+    const int dims[3] = {vol.width, vol.height, vol.depth};
+
+    arena.reset();
+    const Voxels<V> voxels(vol, arena);
+
+    // Slice buffers, sized for the largest slice
+    int sliceSize = 0, rowsSize = 0;
+    for (int d = 0; d < 3; ++d)
     {
-        int v, g;
-    };
+        const int u = (d + 1) % 3;
+        const int v = (d + 2) % 3;
+        sliceSize = std::max(sliceSize, dims[u] * dims[v]);
+        rowsSize  = std::max(rowsSize,
+                             dims[v] * ((dims[u] + WORD_BITS - 1) / WORD_BITS));
+    }
+    Face* faces = arena.alloc<Face>(sliceSize);
+    Quad* quads = arena.alloc<Quad>(sliceSize);
+    Word* rows  = arena.alloc<Word>(rowsSize);
+    std::fill(rows, rows + rowsSize, 0);
+
+    Mesh_P_N_T_UV mesh;
+    const int reserveSize = (dims[0] / 4) * (dims[1] / 4) * (dims[2] / 4);
+    mesh.vertices.reserve(reserveSize);
+    mesh.indices.reserve(reserveSize);
+
+    for (int d = 0; d < 3; ++d)
+    {
+        const int u      = (d + 1) % 3;
+        const int v      = (d + 2) % 3;
+        const int stride = (dims[u] + WORD_BITS - 1) / WORD_BITS;
+
+        int x[3] = {};
+        int q[3] = {};
+        q[d]     = 1;
+
+        for (x[d] = -1; x[d] < dims[d];)
+        {
+            // Collect faces
+            int faceCount = 0, n = 0;
+            for (x[v] = 0; x[v] < dims[v]; ++x[v])
+                for (x[u] = 0; x[u] < dims[u]; ++x[u], ++n)
+                {
+                    const Cell c0 = voxels(x[0],        x[1],        x[2]);
+                    const Cell c1 = voxels(x[0] + q[0], x[1] + q[1], x[2] + q[2]);
+
+                    uint64_t key;
+                    if (faceKey(c0, c1, key))
+                        faces[faceCount++] = {key, n};
+                }
+
+            ++x[d];
+
+            // Merge faces of equal keys
+            std::sort(faces, faces + faceCount);
 
+            int quadCount = 0;
+            for (int f0 = 0, f1 = 0; f0 < faceCount; f0 = f1)
+            {
+                for (f1 = f0 + 1;
+                     f1 < faceCount && faces[f1].key == faces[f0].key; ++f1)
+                {}
+                quadCount += mergeFaces(faces + f0, faces + f1, rows,
+                                        stride, dims[u], dims[v], greedy,
+                                        quads + quadCount);
+            }
+
+            // Emit in scan order
+            std::sort(quads, quads + quadCount);
+
+            for (int k = 0; k < quadCount; ++k)
+            {
+                const Quad& quad = quads[k];
+                x[u] = quad.n % dims[u];
+                x[v] = quad.n / dims[u];
+
+                // Query collapse constants for vertices
+                int cc[8][3];
+                collapseConstants(cc, quad.g);
+
+                glm::ivec3 pos(x[0], x[1], x[2]);
+                if (quad.d > 0) --pos[d];
+
+                glm::ivec3 size(1, 1, 1);
+                size[u] = quad.w;
+                size[v] = quad.h;
+
+                // Determine axis+direction [0, 5]
+                const int axis = d * 2 + (quad.d > 0 ? 1 : 0);
+
+                // Emit quad
+                emitBoxFace(&mesh, scale,
+                             axis, cc, pos, size,
+                            {dims[0], dims[1], dims[2]},
+                             uvCube);
+            }
+        }
+    }
+    return mesh;
+}
+
+// Mask scan of the original mesher, the reference of the binary one. Each
+// slice compares the mask of a cell to its neighbours.
+template <typename V>
+Mesh_P_N_T_UV meshScan(const V& vol,
+                       const RectCube<float>& uvCube,
+                       float scale,
+                       bool greedy)
+{
     struct Mask
     {
         int d, g0, g1;
@@ -100,26 +386,10 @@ Mesh_P_N_T_UV meshGreedy(const V& vol,
     // Dimensions
     const int dims[3] = {vol.width, vol.height, vol.depth};
 
-    // Inside-check
-    const auto in = [&](const int c[3], const int d[3])
-    {return c[0] >= 0    && c[1] >= 0    && c[2] >= 0 &&
-            c[0] <  d[0] && c[1] <  d[1] && c[2] <  d[2];};
-
-    Cell cells[dims[0]][dims[1]][dims[2]];
-    for (int z = 0; z < dims[2]; ++z)
-        for (int y = 0; y < dims[1]; ++y)
-            for (int x = 0; x < dims[0]; ++x)
-            {
-                const int v = vol(x, y, z);
-                cells[x][y][z].v = v;
-                cells[x][y][z].g = v ? vol.g(x, y, z) : 0;
-            }
+    arena.reset();
+    const Voxels<V> voxels(vol, arena);
 
     Mesh_P_N_T_UV mesh;
-    const int reserveSize = (dims[0] / 4) * (dims[1] / 4) * (dims[2] / 4);
-    mesh.vertices.reserve(reserveSize);
-    mesh.indices.reserve(reserveSize);
-
     for (int d = 0; d < 3; ++d)
     {
         const int u = (d + 1) % 3;
@@ -129,7 +399,7 @@ Mesh_P_N_T_UV meshGreedy(const V& vol,
         int q[3] = {};
         q[d]     = 1;
 
-        Mask mask[dims[u] * dims[v]];
+        std::vector<Mask> mask(dims[u] * dims[v]);
 
         for (x[d] = -1; x[d] < dims[d];)
         {
@@ -138,15 +408,12 @@ Mesh_P_N_T_UV meshGreedy(const V& vol,
             for (x[v] = 0; x[v] < dims[v]; ++x[v])
                 for (x[u] = 0; x[u] < dims[u]; ++x[u], ++n)
                 {
-                    const int c0[3] = {x[0],        x[1],        x[2]};
-                    const int c1[3] = {x[0] + q[0], x[1] + q[1], x[2] + q[2]};
-                    const int v0    = in(c0, dims) ? cells[c0[0]][c0[1]][c0[2]].v : 0;
-                    const int v1    = in(c1, dims) ? cells[c1[0]][c1[1]][c1[2]].v : 0;
-                    const int g0    = v0 ? cells[c0[0]][c0[1]][c0[2]].g : 0;
-                    const int g1    = v1 ? cells[c1[0]][c1[1]][c1[2]].g : 0;
-                    const int d     = v0 > 0 && v1 > 0 && g1 != g0 ?
-                                      g1 - g0 : v0 - v1;
-                    mask[n]         = {d, g0, g1};
+                    const Cell c0 = voxels(x[0],        x[1],        x[2]);
+                    const Cell c1 = voxels(x[0] + q[0], x[1] + q[1],
+                                           x[2] + q[2]);
+                    const int  d  = c0.v > 0 && c1.v > 0 && c1.g != c0.g ?
+                                    c1.g - c0.g : c0.v - c1.v;
+                    mask[n]       = {d, c0.g, c1.g};
                 }
 
             ++x[d];
@@ -163,8 +430,8 @@ Mesh_P_N_T_UV meshGreedy(const V& vol,
                         if (greedy)
                         {
                             // Compute width
-                            for (w = 1; m == mask[n + w] && i + w < dims[u]; ++w)
-                            {}
+                            while (i + w < dims[u] && m == mask[n + w])
+                                ++w;
                             // Compute height
                             for (h = 1; j + h < dims[v]; ++h)
                                 for (int k = 0; k < w; ++k)
@@ -225,17 +492,35 @@ Mesh_P_N_T_UV mesh(const Image& image, const geom::Meta& geom)
     return MeshDeformer::smooth(mesh0, geom.smooth);
 }
 
-Mesh_P_N_T_UV mesh(const ImageCube& imageCube,
+Mesh_P_N_T_UV mesh(const Occupancy& occupancy,
                    const RectCube<float>& uvCube,
                    const geom::Meta& geom)
 {
-    const Cubefield cfield(imageCube);
-    auto size  = geom.scale * cfield.size();
-    auto mesh0 = meshGreedy(cfield, uvCube, geom.scale, !geom.smooth);
-    auto mesh1 = MeshDeformer::smooth(mesh0, geom.smooth);
+    auto size  = geom.scale * occupancy.size();
+    auto mesh1 = geom.smooth && geom.mesher == geom::Mesher::SurfaceNets ?
+                 SnMesher::mesh(occupancy, uvCube, geom.scale) :
+                 MeshDeformer::smooth(boxFaces(occupancy, uvCube, geom.scale,
+                                               !geom.smooth),
+                                      geom.smooth);
     return geom.smooth && geom.simplify ?
            MeshDeformer::decimate(mesh1, uvCube, size, geom.simplify) :
-           mesh1;
+           MeshOptimizer::optimize(MeshOptimizer::weld(mesh1));
+}
+
+Mesh_P_N_T_UV boxFaces(const Occupancy& occupancy,
+                       const RectCube<float>& uvCube,
+                       float scale,
+                       bool greedy)
+{
+    return meshGreedy(occupancy, uvCube, scale, greedy);
+}
+
+Mesh_P_N_T_UV boxFacesScan(const Occupancy& occupancy,
+                           const RectCube<float>& uvCube,
+                           float scale,
+                           bool greedy)
+{
+    return meshScan(occupancy, uvCube, scale, greedy);
 }
 
 } // namespace ImageMesher
@@ -3,6 +3,7 @@
 #include "img/image_cube.h"
 #include "img/image.h"
 #include "geom/meta.h"
+#include "occupancy.h"
 #include "mesh.h"
 
 namespace pt
@@ -13,9 +14,22 @@ namespace ImageMesher
 Mesh_P_N_T_UV mesh(const Image& image,
                    const geom::Meta& geom);
 
-Mesh_P_N_T_UV mesh(const ImageCube& imageCube,
+Mesh_P_N_T_UV mesh(const Occupancy& occupancy,
                    const RectCube<float>& uvCube,
                    const geom::Meta& geom);
 
+// Box faces of the volume before deformers, merged into quads when greedy
+Mesh_P_N_T_UV boxFaces(const Occupancy& occupancy,
+                       const RectCube<float>& uvCube,
+                       float scale,
+                       bool greedy = true);
+
+// Box faces by the mask scan of the original mesher, which boxFaces()
+// matches quad for quad
+Mesh_P_N_T_UV boxFacesScan(const Occupancy& occupancy,
+                           const RectCube<float>& uvCube,
+                           float scale,
+                           bool greedy = true);
+
 } // namespace ImageMesher
 } // namespace pt
@@ -8,6 +8,7 @@
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include "rect.h"
 
@@ -16,8 +17,8 @@ namespace pt
 
 struct VertexSpec
 {
-    // Component count, type, size in bytes
-    using Attrib = std::tuple<int, GLenum, std::size_t>;
+    // Component count, type, size in bytes, normalized
+    using Attrib = std::tuple<int, GLenum, std::size_t, bool>;
 
     std::size_t         size;
     std::vector<Attrib> attribs;
@@ -30,7 +31,7 @@ struct Vertex_P
     static VertexSpec spec()
     {
         return {sizeof(Vertex_P),
-               {std::make_tuple(3, GL_FLOAT, sizeof(p))}};
+               {std::make_tuple(3, GL_FLOAT, sizeof(p), false)}};
     }
 };
 
@@ -42,8 +43,8 @@ struct Vertex_P_UV
     static VertexSpec spec()
     {
         return {sizeof(Vertex_P_UV),
-               {std::make_tuple(3, GL_FLOAT, sizeof(p)),
-                std::make_tuple(2, GL_FLOAT, sizeof(uv))}};
+               {std::make_tuple(3, GL_FLOAT, sizeof(p), false),
+                std::make_tuple(2, GL_FLOAT, sizeof(uv), false)}};
     }
 };
 
@@ -56,9 +57,9 @@ struct Vertex_P_N_UV
     static VertexSpec spec()
     {
         return {sizeof(Vertex_P_N_UV),
-               {std::make_tuple(3, GL_FLOAT, sizeof(p)),
-                std::make_tuple(3, GL_FLOAT, sizeof(n)),
-                std::make_tuple(2, GL_FLOAT, sizeof(uv))}};
+               {std::make_tuple(3, GL_FLOAT, sizeof(p), false),
+                std::make_tuple(3, GL_FLOAT, sizeof(n), false),
+                std::make_tuple(2, GL_FLOAT, sizeof(uv), false)}};
     }
 };
 
@@ -72,10 +73,30 @@ struct Vertex_P_N_T_UV
     static VertexSpec spec()
     {
         return {sizeof(Vertex_P_N_T_UV),
-               {std::make_tuple(3, GL_FLOAT, sizeof(p)),
-                std::make_tuple(3, GL_FLOAT, sizeof(n)),
-                std::make_tuple(3, GL_FLOAT, sizeof(t)),
-                std::make_tuple(2, GL_FLOAT, sizeof(uv))}};
+               {std::make_tuple(3, GL_FLOAT, sizeof(p), false),
+                std::make_tuple(3, GL_FLOAT, sizeof(n), false),
+                std::make_tuple(3, GL_FLOAT, sizeof(t), false),
+                std::make_tuple(2, GL_FLOAT, sizeof(uv), false)}};
+    }
+};
+
+// Quantized vertex: position as unorm16 within the mesh bounds, normal and
+// tangent octahedral-encoded as snorm16, uv as unorm16. The fourth position
+// component is the tangent handedness, set on mirrored vertices.
+struct Vertex_Packed
+{
+    glm::u16vec4 p;
+    glm::i16vec2 n;
+    glm::i16vec2 t;
+    glm::u16vec2 uv;
+
+    static VertexSpec spec()
+    {
+        return {sizeof(Vertex_Packed),
+               {std::make_tuple(4, GL_UNSIGNED_SHORT, sizeof(p),  true),
+                std::make_tuple(2, GL_SHORT,          sizeof(n),  true),
+                std::make_tuple(2, GL_SHORT,          sizeof(t),  true),
+                std::make_tuple(2, GL_UNSIGNED_SHORT, sizeof(uv), true)}};
     }
 };
 
@@ -117,6 +138,7 @@ using Mesh_P        = Mesh<Vertex_P,        uint32_t>;
 using Mesh_P_UV     = Mesh<Vertex_P_UV,     uint32_t>;
 using Mesh_P_N_UV   = Mesh<Vertex_P_N_UV,   uint32_t>;
 using Mesh_P_N_T_UV = Mesh<Vertex_P_N_T_UV, uint32_t>;
+using Mesh_Packed   = Mesh<Vertex_Packed,   uint32_t>;
 
 inline Mesh_P_UV rectMesh(float halfWidth = 1.f, float halfHeight = 1.f)
 {
@@ -1,17 +1,16 @@
 #include "mesh_deformer.h"
 
+#include <limits>
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
 #include <algorithm>
 
 #include <glm/vec3.hpp>
-#include <glm/gtx/hash.hpp>
 
 #include "platform/clock.h"
 #include "common/log.h"
 
 #include "mesh_common.h"
+#include "mesh_optimizer.h"
 #include "mesh_simplifier.h"
 
 namespace pt
@@ -19,12 +18,7 @@ namespace pt
 namespace MeshDeformer
 {
 // Types
-using Indices       = std::vector<int>;
-using PosNormal     = std::pair<glm::vec3, glm::vec3>;
-using Locations     = std::unordered_map<glm::vec3, Indices>;
-using Neighbors     = std::vector<Indices>;
 using Displacements = std::vector<std::array<glm::vec3, 3>>;
-using UniqueMesh    = std::pair<Mesh, Locations>;
 
 template <typename M>
 MeshSimplifier::Simplifier::Verts meshVertices(const M& mesh)
@@ -63,66 +57,121 @@ MeshSimplifier::Simplifier::Tris meshTriangles(const M& mesh)
 namespace
 {
 
-Neighbors vertexNeighbors(const Mesh& mesh)
+// Vertices grouped by equal position. Members of group g are
+// order[offsets[g], offsets[g + 1]) in ascending index order.
+struct Welding
 {
-    const auto& v = mesh.vertices;
-    const int vc  = int(v.size());
+    std::vector<int> group;
+    std::vector<int> offsets;
+    std::vector<int> order;
+
+    int groupCount() const
+    {
+        return int(offsets.size()) - 1;
+    }
+};
+
+// One-ring adjacency of a triangle soup in CSR form. Each vertex adds the
+// edge opposite to it in its triangle to the ring of its position group.
+struct Adjacency
+{
+    Welding          welding;
+    std::vector<int> ring;
+
+    int begin(int i) const
+    {
+        return 2 * welding.offsets[welding.group[i]];
+    }
 
-    Locations locations(vc / 8);
-    for (int i = 0; i < vc; i += 3)
+    int end(int i) const
     {
-        auto& l0 = locations[v[i + 0].p];
-        auto& l1 = locations[v[i + 1].p];
-        auto& l2 = locations[v[i + 2].p];
-        l0.insert(l0.end(), {i + 1, i + 2});
-        l1.insert(l1.end(), {i + 2, i + 0});
-        l2.insert(l2.end(), {i + 0, i + 1});
+        return 2 * welding.offsets[welding.group[i] + 1];
     }
+};
 
-    Neighbors neighbors(vc);
+Welding weldPositions(const Mesh& mesh)
+{
+    struct Key
+    {
+        glm::vec3 p;
+        int       i;
+
+        bool operator<(const Key& key) const
+        {
+            if (p.x != key.p.x) return p.x < key.p.x;
+            if (p.y != key.p.y) return p.y < key.p.y;
+            if (p.z != key.p.z) return p.z < key.p.z;
+            return i < key.i;
+        }
+    };
+
+    const auto& v = mesh.vertices;
+    const int vc  = int(v.size());
+
+    std::vector<Key> keys(vc);
     #pragma omp parallel for
     for (int i = 0; i < vc; ++i)
-        neighbors[i] = locations[v[i].p];
+        keys[i] = {v[i].p, i};
+
+    std::sort(keys.begin(), keys.end());
+
+    Welding welding;
+    welding.group.resize(vc);
+    welding.order.resize(vc);
+    welding.offsets.reserve(vc / 4 + 1);
+    for (int k = 0; k < vc; ++k)
+    {
+        if (!k || keys[k].p != keys[k - 1].p)
+            welding.offsets.push_back(k);
 
-    return neighbors;
+        welding.order[k]         = keys[k].i;
+        welding.group[keys[k].i] = welding.groupCount();
+    }
+    welding.offsets.push_back(vc);
+    return welding;
 }
 
-UniqueMesh connect(const Mesh_P_N_T_UV& mesh0)
+Adjacency vertexNeighbors(const Mesh& mesh)
 {
-    //PTTIMEU("connect", boost::milli);
-    const auto vc0 = int(mesh0.vertices.size());
+    Adjacency adjacency;
+    adjacency.welding = weldPositions(mesh);
 
-    Locations locations(vc0 / 8);
-    for (int i = 0; i < vc0; ++i)
-        locations[mesh0.vertices[i].p].emplace_back(i);
+    const auto& order = adjacency.welding.order;
+    const int vc      = int(order.size());
 
-    std::vector<int> indexMap(vc0);
-    std::vector<Mesh::Vertex> vertexMap(locations.size());
-
-    int index = 0;
-    for (const auto& loc : locations)
+    adjacency.ring.resize(2 * vc);
+    #pragma omp parallel for
+    for (int k = 0; k < vc; ++k)
     {
-        for (const auto i : loc.second)
-            indexMap[i] = index;
-
-        vertexMap[index++] = mesh0.vertices[loc.second.front()];
+        const int i = order[k];
+        const int t = i - i % 3;
+        adjacency.ring[2 * k + 0] = t + (i - t + 1) % 3;
+        adjacency.ring[2 * k + 1] = t + (i - t + 2) % 3;
     }
+    return adjacency;
+}
+
+Mesh connect(const Mesh_P_N_T_UV& mesh0)
+{
+    //PTTIMEU("connect", boost::milli);
+    const auto welding = weldPositions(mesh0);
+    const auto vc1     = welding.groupCount();
+    const auto ic1     = int(mesh0.indices.size());
 
-    // Reconstruct mesh
-    const auto vc1 = int(vertexMap.size());
-    const auto ic1 = int(mesh0.indices.size());
     std::vector<Mesh::Vertex> vertices(vc1);
     std::vector<Mesh::Index>  indices(ic1);
 
     // Vertices
+    #pragma omp parallel for
     for (int i = 0; i < vc1; ++i)
-        vertices[i] = vertexMap[i];
+        vertices[i] = mesh0.vertices[welding.order[welding.offsets[i]]];
 
     // Indices
+    #pragma omp parallel for
     for (int i = 0; i < ic1; ++i)
-        indices[i] = indexMap[i];
+        indices[i] = Mesh::Index(welding.group[mesh0.indices[i]]);
 
-    return {Mesh(vertices, indices), locations};
+    return Mesh(vertices, indices);
 }
 
 } // namespace
@@ -135,18 +184,23 @@ Mesh_P_N_T_UV decimate(const Mesh_P_N_T_UV& mesh0,
     auto mesh1 = connect(mesh0);
     //PTTIMEU("decimate", boost::milli);
 
-    auto v = meshVertices(mesh1.first);
-    auto t = meshTriangles(mesh1.first);
+    auto v = meshVertices(mesh1);
+    auto t = meshTriangles(mesh1);
 
     MeshSimplifier::Simplifier simplifier(t, v);
-    simplifier.simplify(params.iterations, params.strength, params.scale);
+    if (params.queued())
+        simplifier.simplifyTo(int(params.target * t.size()),
+                              params.error > 0.f ? params.error :
+                              std::numeric_limits<float>::max());
+    else
+        simplifier.simplify(params.iterations, params.strength, params.scale);
 
     const int vc0 = int(v.size());
     const int tc0 = int(t.size());
 
     #if 0
-    PTLOG(Info) << mesh1.first.vertices.size() << " / "
-                << mesh1.first.triangleCount() << " -> " << vc0 << " / " << tc0;
+    PTLOG(Info) << mesh1.vertices.size() << " / "
+                << mesh1.triangleCount() << " -> " << vc0 << " / " << tc0;
     #endif
 
     Mesh_P_N_T_UV mesh2;
@@ -178,19 +232,20 @@ Mesh_P_N_T_UV decimate(const Mesh_P_N_T_UV& mesh0,
         {0, 1}, {0, 1},
     };
     const int axisSide[6] = {2, 3, 5, 4, 1, 0};
-    const auto neighbors  = vertexNeighbors(mesh2);
+    const auto adjacency  = vertexNeighbors(mesh2);
+    const auto& ring      = adjacency.ring;
     const auto vc1        = int(mesh2.vertices.size());
     const auto tc1        = int(mesh2.triangleCount());
+    #pragma omp parallel for
     for (int i = 0; i < vc1; ++i)
     {
         auto&       v0  = mesh2.vertices[i];
-        const auto& idx = neighbors[i];
-        const auto  ic  = int(idx.size());
+        const auto  end = adjacency.end(i);
         glm::vec3   n   = glm::zero<glm::vec3>();
-        for (int j = 0; j < ic; j += 2)
+        for (int j = adjacency.begin(i); j < end; j += 2)
         {
-            const auto& v1 = mesh2.vertices[idx[j + 0]];
-            const auto& v2 = mesh2.vertices[idx[j + 1]];
+            const auto& v1 = mesh2.vertices[ring[j + 0]];
+            const auto& v2 = mesh2.vertices[ring[j + 1]];
             const auto  e0 = v1.p - v0.p,
                         e1 = v2.p - v1.p;
             const auto  l0 = glm::length(e0),
@@ -219,7 +274,7 @@ Mesh_P_N_T_UV decimate(const Mesh_P_N_T_UV& mesh0,
         v1.t = t;
         v2.t = t;
     }
-    return mesh2;
+    return MeshOptimizer::optimize(MeshOptimizer::weld(mesh2));
 }
 
 Mesh smooth(const Mesh& mesh0, const geom::Smooth& params)
@@ -231,7 +286,8 @@ Mesh smooth(const Mesh& mesh0, const geom::Smooth& params)
         const auto vc = int(mesh1.vertices.size());
 
         // Find neighbors
-        const auto neighbors = vertexNeighbors(mesh1);
+        const auto adjacency = vertexNeighbors(mesh1);
+        const auto& ring     = adjacency.ring;
 
         // Smooth iteratively with strength lambda
         const auto lambda = params.strength;
@@ -248,12 +304,11 @@ Mesh smooth(const Mesh& mesh0, const geom::Smooth& params)
             #pragma omp parallel for
             for (int i = 0; i < vc; ++i)
             {
-                const auto& v0 = mesh1.vertices[i];
-                const auto& n  = neighbors[i];
-                const auto nc  = int(n.size());
-                for (int j = 0; j < nc; ++j)
+                const auto& v0  = mesh1.vertices[i];
+                const auto  end = adjacency.end(i);
+                for (int j = adjacency.begin(i); j < end; ++j)
                 {
-                    const auto& v1 = mesh1.vertices[n[j]];
+                    const auto& v1 = mesh1.vertices[ring[j]];
                     d[i][0] += v0.p - v1.p;
                     d[i][1] += v0.n - v1.n;
                     d[i][2] += v0.t - v1.t;
@@ -265,7 +320,7 @@ Mesh smooth(const Mesh& mesh0, const geom::Smooth& params)
             #pragma omp parallel for
             for(int i = 0; i < vc; ++i)
             {
-                const auto w = 1.f / neighbors[i].size();
+                const auto w = 1.f / (adjacency.end(i) - adjacency.begin(i));
                 auto& v1     = mesh1.vertices[i];
                 v1.p += s * w * d[i][0];
                 v1.n += s * w * d[i][1];
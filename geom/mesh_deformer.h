@@ -13,6 +13,7 @@ namespace MeshDeformer
 // Types
 using Mesh = Mesh_P_N_T_UV;
 
+// Returns an indexed mesh ordered for vertex cache locality
 Mesh decimate(const Mesh& mesh0,
               const RectCube<float>& uvCube,
               const glm::vec3& size,
@@ -0,0 +1,329 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/hash.hpp>
+
+namespace pt
+{
+namespace MeshOptimizer
+{
+
+namespace
+{
+
+// Attributes quantized to the weld tolerance
+struct WeldKey
+{
+    glm::ivec3 p, n;
+    glm::ivec2 uv;
+
+    bool operator==(const WeldKey& key) const
+    {
+        return p == key.p && n == key.n && uv == key.uv;
+    }
+};
+
+struct WeldKeyHash
+{
+    std::size_t operator()(const WeldKey& key) const
+    {
+        const auto combine = [](std::size_t seed, std::size_t h)
+        {return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));};
+
+        return combine(combine(std::hash<glm::ivec3>()(key.p),
+                               std::hash<glm::ivec3>()(key.n)),
+                               std::hash<glm::ivec2>()(key.uv));
+    }
+};
+
+// Forsyth scoring
+constexpr int   CACHE_SIZE          = 32;
+constexpr float CACHE_DECAY_POWER   = 1.5f;
+constexpr float LAST_TRI_SCORE      = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+float vertexScore(int cachePos, int remaining)
+{
+    if (!remaining)
+        return -1.f;
+
+    float score = 0.f;
+    if (cachePos >= 0)
+        score = cachePos < 3 ? LAST_TRI_SCORE :
+                std::pow(1.f - float(cachePos - 3) / (CACHE_SIZE - 3),
+                         CACHE_DECAY_POWER);
+
+    return score + VALENCE_BOOST_SCALE *
+                   std::pow(float(remaining), -VALENCE_BOOST_POWER);
+}
+
+// Octahedral encoding of a unit vector as snorm16
+glm::i16vec2 octEncode(glm::vec3 v)
+{
+    v /= std::abs(v.x) + std::abs(v.y) + std::abs(v.z) + 1e-20f;
+
+    glm::vec2 e(v.x, v.y);
+    if (v.z < 0.f)
+        e = (1.f - glm::abs(glm::vec2(v.y, v.x))) *
+            glm::vec2(v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f);
+
+    return glm::i16vec2(glm::round(glm::clamp(e, -1.f, 1.f) * 32767.f));
+}
+
+} // namespace
+
+Mesh weld(const Mesh& mesh0, float tolerance, float tangentCos)
+{
+    const auto quantize = [=](float x)
+    {return int(std::floor(x / tolerance + 0.5f));};
+
+    const int ic = int(mesh0.indices.size());
+
+    Mesh mesh1;
+    mesh1.indices.resize(ic);
+
+    std::unordered_map<WeldKey, std::vector<int>, WeldKeyHash> welds(ic / 2);
+    std::vector<glm::vec3> tangents;
+
+    for (int i = 0; i < ic; ++i)
+    {
+        const auto& v = mesh0.vertices[mesh0.indices[i]];
+        const WeldKey key {{quantize(v.p.x),  quantize(v.p.y),  quantize(v.p.z)},
+                           {quantize(v.n.x),  quantize(v.n.y),  quantize(v.n.z)},
+                           {quantize(v.uv.x), quantize(v.uv.y)}};
+
+        // Match the first candidate with a close enough tangent
+        auto& candidates = welds[key];
+        int index = -1;
+        for (const auto c : candidates)
+            if (glm::dot(mesh1.vertices[c].t, v.t) >= tangentCos)
+            {
+                index = c;
+                break;
+            }
+
+        if (index < 0)
+        {
+            index = int(mesh1.vertices.size());
+            candidates.push_back(index);
+            mesh1.vertices.push_back(v);
+            tangents.push_back(v.t);
+        }
+        else
+            tangents[index] += v.t;
+
+        mesh1.indices[i] = Mesh::Index(index);
+    }
+
+    // Average tangents, orthogonal to the normal
+    #pragma omp parallel for
+    for (int i = 0; i < int(mesh1.vertices.size()); ++i)
+    {
+        auto&      v = mesh1.vertices[i];
+        const auto t = tangents[i] - v.n * glm::dot(v.n, tangents[i]);
+        if (glm::dot(t, t) > 0.f)
+            v.t = glm::normalize(t);
+    }
+    return mesh1;
+}
+
+Mesh optimize(const Mesh& mesh0)
+{
+    const int tc = mesh0.triangleCount();
+    const int vc = int(mesh0.vertices.size());
+    const auto& indices = mesh0.indices;
+
+    // Vertex to triangle adjacency, live triangles first in each range
+    std::vector<int> offsets(vc + 1, 0), remaining(vc, 0);
+    for (const auto i : indices)
+        ++remaining[i];
+    for (int i = 0; i < vc; ++i)
+        offsets[i + 1] = offsets[i] + remaining[i];
+
+    std::vector<int> adjacency(offsets[vc]);
+    {
+        std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (int t = 0; t < tc; ++t)
+            for (int k = 0; k < 3; ++k)
+                adjacency[fill[indices[3 * t + k]]++] = t;
+    }
+
+    std::vector<int>   cachePos(vc, -1);
+    std::vector<float> vertexScores(vc), triangleScores(tc, 0.f);
+    std::vector<char>  added(tc, 0);
+
+    for (int i = 0; i < vc; ++i)
+        vertexScores[i] = vertexScore(-1, remaining[i]);
+    for (int t = 0; t < tc; ++t)
+        for (int k = 0; k < 3; ++k)
+            triangleScores[t] += vertexScores[indices[3 * t + k]];
+
+    std::vector<int> order, cache, next;
+    order.reserve(tc);
+    cache.reserve(CACHE_SIZE + 3);
+    next.reserve(CACHE_SIZE + 3);
+
+    int best = int(std::max_element(triangleScores.begin(),
+                                     triangleScores.end()) -
+                   triangleScores.begin());
+    int cursor = 0;
+
+    while (int(order.size()) < tc)
+    {
+        // Without candidates in the cache, continue with the next triangle
+        // in input order
+        if (best < 0)
+        {
+            while (added[cursor])
+                ++cursor;
+            best = cursor;
+        }
+
+        order.push_back(best);
+        added[best] = 1;
+
+        const auto* tri = &indices[3 * best];
+        for (int k = 0; k < 3; ++k)
+        {
+            const int v     = tri[k];
+            auto      begin = adjacency.begin() + offsets[v];
+            auto      end   = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            --remaining[v];
+        }
+
+        // Triangle vertices move to the front of the cache
+        next.assign(tri, tri + 3);
+        for (const auto v : cache)
+            if (v != int(tri[0]) && v != int(tri[1]) && v != int(tri[2]))
+                next.push_back(v);
+
+        for (int i = 0, c = int(next.size()); i < c; ++i)
+        {
+            const int v   = next[i];
+            cachePos[v]   = i < CACHE_SIZE ? i : -1;
+            const float s = vertexScore(cachePos[v], remaining[v]);
+            const float d = s - vertexScores[v];
+            vertexScores[v] = s;
+            for (int j = offsets[v]; j < offsets[v] + remaining[v]; ++j)
+                triangleScores[adjacency[j]] += d;
+        }
+        next.resize(std::min(int(next.size()), CACHE_SIZE));
+        std::swap(cache, next);
+
+        // Best live triangle touching the cache
+        best = -1;
+        float bestScore = -1.f;
+        for (const auto v : cache)
+            for (int j = offsets[v]; j < offsets[v] + remaining[v]; ++j)
+            {
+                const int t = adjacency[j];
+                if (triangleScores[t] > bestScore)
+                {
+                    best      = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+    }
+
+    // Vertices in order of first use
+    Mesh mesh1;
+    mesh1.vertices.reserve(vc);
+    mesh1.indices.reserve(indices.size());
+
+    std::vector<int> remap(vc, -1);
+    for (const auto t : order)
+        for (int k = 0; k < 3; ++k)
+        {
+            const int v = indices[3 * t + k];
+            if (remap[v] < 0)
+            {
+                remap[v] = int(mesh1.vertices.size());
+                mesh1.vertices.push_back(mesh0.vertices[v]);
+            }
+            mesh1.indices.push_back(Mesh::Index(remap[v]));
+        }
+
+    return mesh1;
+}
+
+float acmr(const Mesh& mesh, int cacheSize)
+{
+    // A vertex is cached while fewer than cacheSize misses followed its own
+    std::vector<int> entered(mesh.vertices.size(), -cacheSize - 1);
+
+    int misses = 0;
+    for (const auto i : mesh.indices)
+        if (entered[i] < misses - cacheSize)
+            entered[i] = misses++;
+
+    return mesh.triangleCount() ? float(misses) / mesh.triangleCount() : 0.f;
+}
+
+Mesh_Packed quantize(const Mesh& mesh, glm::mat4& unpack, int layer)
+{
+    glm::vec3 lo(0.f), hi(0.f);
+    if (!mesh.vertices.empty())
+        lo = hi = mesh.vertices.front().p;
+    for (const auto& v : mesh.vertices)
+    {
+        lo = glm::min(lo, v.p);
+        hi = glm::max(hi, v.p);
+    }
+
+    // Uniform scale keeps normal transforms valid without inverse-transpose
+    const auto extent = std::max(std::max(hi.x - lo.x, hi.y - lo.y),
+                                 std::max(hi.z - lo.z, 1e-6f));
+    unpack = glm::scale(glm::translate(glm::mat4(1.f), lo), glm::vec3(extent));
+
+    Mesh_Packed packed;
+    packed.indices = mesh.indices;
+    packed.vertices.resize(mesh.vertices.size());
+
+    #pragma omp parallel for
+    for (int i = 0; i < int(mesh.vertices.size()); ++i)
+    {
+        const auto& v0 = mesh.vertices[i];
+        auto&       v1 = packed.vertices[i];
+        const auto  p  = glm::clamp((v0.p - lo) / extent, 0.f, 1.f);
+        v1.p  = glm::u16vec4(glm::round(p * 65535.f), layer);
+        v1.n  = octEncode(v0.n);
+        v1.t  = octEncode(v0.t);
+        v1.uv = glm::u16vec2(glm::round(glm::clamp(v0.uv, 0.f, 1.f) * 65535.f));
+    }
+    return packed;
+}
+
+Mesh_Packed mirrored(const Mesh_Packed& mesh, glm::mat4& unpack, float width)
+{
+    Mesh_Packed mirror(mesh);
+
+    // Octahedral encodings reflect in X by negating their first component
+    #pragma omp parallel for
+    for (int i = 0; i < int(mirror.vertices.size()); ++i)
+    {
+        auto& v = mirror.vertices[i];
+        v.p.x = uint16_t(65535 - v.p.x);
+        v.p.w = uint16_t(v.p.w ^ 0x8000);
+        v.n.x = int16_t(-v.n.x);
+        v.t.x = int16_t(-v.t.x);
+    }
+
+    // Restore the winding
+    for (int i = 0; i < mirror.triangleCount(); ++i)
+        std::swap(mirror.indices[3 * i + 1], mirror.indices[3 * i + 2]);
+
+    unpack[3][0] = width - unpack[3][0] - unpack[0][0];
+    return mirror;
+}
+
+} // namespace MeshOptimizer
+} // namespace pt
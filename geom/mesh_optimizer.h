@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+
+#include "mesh.h"
+
+namespace pt
+{
+namespace MeshOptimizer
+{
+// Types
+using Mesh = Mesh_P_N_T_UV;
+
+// Merges vertices that agree in position, normal and UV within tolerance
+// and whose tangents lie within the given cosine into an indexed mesh.
+// Tangents of merged vertices are averaged.
+Mesh weld(const Mesh& mesh0,
+          float tolerance = 1e-4f,
+          float tangentCos = 0.9f);
+
+// Orders triangles for post-transform cache locality (Forsyth), then
+// vertices by first use
+Mesh optimize(const Mesh& mesh0);
+
+// Average cache miss ratio, vertices transformed per triangle, of a FIFO
+// post-transform cache
+float acmr(const Mesh& mesh, int cacheSize = 32);
+
+// Packs the mesh into quantized vertices. Positions are stored relative to
+// the cube spanning the mesh bounds, which 'unpack' maps back to model space.
+// The atlas layer of the UVs is stored below the handedness bit of p.w.
+Mesh_Packed quantize(const Mesh& mesh, glm::mat4& unpack, int layer = 0);
+
+// Reflects a quantized mesh across the plane x = width / 2, updating its
+// 'unpack' transform. UVs are kept, so the mirror samples the same texels.
+Mesh_Packed mirrored(const Mesh_Packed& mesh, glm::mat4& unpack, float width);
+
+} // namespace MeshOptimizer
+} // namespace pt
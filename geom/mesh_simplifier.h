@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <functional>
+#include <limits>
+#include <queue>
 #include <vector>
 
 #include <glm/vec3.hpp>
@@ -93,10 +97,12 @@ struct Triangle
 
 struct Vertex
 {
-    Vertex()
+    Vertex() :
+        tstart(0), tcount(0), border(0)
     {}
 
-    Vertex(const glm::vec3& p) : p(p)
+    Vertex(const glm::vec3& p) :
+        p(p), tstart(0), tcount(0), border(0)
     {}
 
     glm::vec3 p;
@@ -208,6 +214,129 @@ struct Simplifier
         compactMesh();
     }
 
+    // Collapses edges in order of increasing error until at most targetCount
+    // triangles remain or the cheapest collapse exceeds maxError
+    void simplifyTo(int targetCount,
+                    Scalar maxError = std::numeric_limits<Scalar>::max())
+    {
+        struct Collapse
+        {
+            Scalar error;
+            int    i0, i1, stamp0, stamp1;
+
+            bool operator>(const Collapse& c) const
+            {
+                return error > c.error;
+            }
+        };
+        using Queue = std::priority_queue<Collapse, std::vector<Collapse>,
+                                          std::greater<Collapse>>;
+
+        for (auto& t : triangles)
+            t.deleted = 0;
+
+        updateMesh(0);
+
+        // Initial collapses, one per triangle edge
+        const int tc = int(triangles.size());
+        std::vector<Collapse> collapses(tc * 3);
+        #pragma omp parallel for
+        for (int ti = 0; ti < tc; ++ti)
+            for (int j = 0; j < 3; ++j)
+            {
+                const int i0 = triangles[ti].v[j];
+                const int i1 = triangles[ti].v[(j + 1) % 3];
+                glm::vec3 p;
+                collapses[ti * 3 + j] =
+                    vertices[i0].border == vertices[i1].border ?
+                    Collapse {calcError(i0, i1, p), i0, i1, 0, 0} :
+                    Collapse {0, -1, -1, 0, 0};
+            }
+        collapses.erase(std::remove_if(collapses.begin(), collapses.end(),
+                                       [](const Collapse& c) {return c.i0 < 0;}),
+                        collapses.end());
+
+        Queue queue(std::greater<Collapse>(), std::move(collapses));
+
+        // Collapses are stale once either vertex has changed
+        std::vector<int> stamps(vertices.size(), 0);
+        const auto push = [&](int i0, int i1)
+        {
+            if (vertices[i0].border != vertices[i1].border)
+                return;
+
+            glm::vec3 p;
+            queue.push({calcError(i0, i1, p), i0, i1, stamps[i0], stamps[i1]});
+        };
+
+        int deletedTriangles = 0;
+        std::vector<int> deleted0, deleted1;
+
+        while (tc - deletedTriangles > targetCount && !queue.empty())
+        {
+            const auto c = queue.top();
+            queue.pop();
+
+            if (c.error > maxError)
+                break;
+            if (c.stamp0 != stamps[c.i0] || c.stamp1 != stamps[c.i1])
+                continue;
+
+            auto& v0 = vertices[c.i0];
+            auto& v1 = vertices[c.i1];
+
+            // Compute vertex to collapse to
+            glm::vec3 p;
+            calcError(c.i0, c.i1, p);
+
+            deleted0.resize(v0.tcount);
+            deleted1.resize(v1.tcount);
+
+            // Do not remove if flipped
+            if (flipped(p, c.i0, c.i1, v0, v1, deleted0)) continue;
+            if (flipped(p, c.i1, c.i0, v1, v0, deleted1)) continue;
+
+            // Not flipped, remove edge
+            v0.p = p;
+            v0.q = v1.q + v0.q;
+            int tstart = int(refs.size());
+
+            updateTriangles(c.i0, v0, deleted0, deletedTriangles);
+            updateTriangles(c.i0, v1, deleted1, deletedTriangles);
+
+            int tcount = int(refs.size()) - tstart;
+            if(tcount <= v0.tcount)
+            {
+                if(tcount)
+                    std::copy(&refs[tstart], &refs[tstart] + tcount,
+                              &refs[v0.tstart]);
+            }
+            else
+                v0.tstart = tstart;
+
+            v0.tcount = tcount;
+            ++stamps[c.i0];
+            ++stamps[c.i1];
+
+            // Requeue the edges of the merged vertex
+            for (int k = 0; k < v0.tcount; ++k)
+            {
+                const auto& r = refs[v0.tstart + k];
+                const auto& t = triangles[r.tid];
+                if (t.deleted)
+                    continue;
+
+                push(c.i0, t.v[(r.tvertex + 1) % 3]);
+                push(c.i0, t.v[(r.tvertex + 2) % 3]);
+            }
+
+            // Drop refs orphaned by relocated vertex lists
+            if (refs.size() > triangles.size() * 6)
+                updateRefs();
+        }
+        compactMesh();
+    }
+
     bool flipped(const glm::vec3& p, int /*i0*/, int i1,
                  const Vertex& v0, const Vertex& /*v1*/,
                  std::vector<int>& deleted) const
@@ -312,41 +441,30 @@ struct Simplifier
 
             triangles.resize(dst);
         }
-        //if (iter == 0)
-        {
-            for (auto& v : vertices)
-                v.q = SymMat(0.f);
-
-            for (auto& t : triangles)
-            {
-                const auto& p0 = vertices[t.v[0]].p;
-                const auto& p1 = vertices[t.v[1]].p;
-                const auto& p2 = vertices[t.v[2]].p;
-                t.n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-                for (int j = 0; j < 3; ++j)
-                    vertices[t.v[j]].q += SymMat(t.n.x, t.n.y, t.n.z,
-                                                 glm::dot(-t.n, p0));
-            }
-            for (auto& t : triangles)
-            {
-                glm::vec3 p;
-                for (int j = 0; j < 3; ++j)
-                    t.err[j] = calcError(t.v[j], t.v[(j + 1) % 3], p);
-
-                t.err[3] = std::min(t.err[0], std::min(t.err[1], t.err[2]));
-            }
-        }
+        // Borders first, collapse errors depend on them
+        updateRefs();
+        updateBorders();
+        updateQuadrics();
+    }
 
+    // Vertex to triangle references of the remaining triangles, in
+    // triangle order
+    void updateRefs()
+    {
         for (auto& v : vertices)
         {
             v.tstart = 0;
             v.tcount = 0;
         }
-        for (auto& t : triangles)
-        {
-            for (int j = 0; j < 3; ++j)
-                vertices[t.v[j]].tcount++;
-        }
+        int refCount = 0;
+        for (const auto& t : triangles)
+            if (!t.deleted)
+            {
+                for (int j = 0; j < 3; ++j)
+                    vertices[t.v[j]].tcount++;
+                refCount += 3;
+            }
+
         int tstart = 0;
         for (auto& v : vertices)
         {
@@ -355,10 +473,13 @@ struct Simplifier
             v.tcount = 0;
         }
 
-        refs.resize(triangles.size() * 3);
+        refs.resize(refCount);
         for (int i = 0, c = int(triangles.size()); i < c; ++i)
         {
             auto& t = triangles[i];
+            if (t.deleted)
+                continue;
+
             for (int j = 0; j < 3; ++j)
             {
                 auto& v = vertices[t.v[j]];
@@ -367,22 +488,68 @@ struct Simplifier
                 ++v.tcount;
             }
         }
+    }
+
+    // Plane quadrics are computed per triangle and gathered per vertex
+    // through the refs, which adds them in the same order as a serial
+    // scatter over the triangles would
+    void updateQuadrics()
+    {
+        const int tc = int(triangles.size());
+        const int vc = int(vertices.size());
 
-        //if (iter == 0)
+        std::vector<SymMat> planes(tc);
+        #pragma omp parallel for
+        for (int i = 0; i < tc; ++i)
         {
-            std::vector<int> vcount, vids;
+            auto& t = triangles[i];
+            const auto& p0 = vertices[t.v[0]].p;
+            const auto& p1 = vertices[t.v[1]].p;
+            const auto& p2 = vertices[t.v[2]].p;
+            t.n       = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+            planes[i] = SymMat(t.n.x, t.n.y, t.n.z, glm::dot(-t.n, p0));
+        }
+
+        #pragma omp parallel for
+        for (int i = 0; i < vc; ++i)
+        {
+            auto& v = vertices[i];
+            v.q = SymMat(0.f);
+            for (int j = 0; j < v.tcount; ++j)
+                v.q += planes[refs[v.tstart + j].tid];
+        }
+
+        #pragma omp parallel for
+        for (int i = 0; i < tc; ++i)
+        {
+            auto& t = triangles[i];
+            glm::vec3 p;
+            for (int j = 0; j < 3; ++j)
+                t.err[j] = calcError(t.v[j], t.v[(j + 1) % 3], p);
 
-            for (auto& v : vertices)
-                v.border = 0;
+            t.err[3] = std::min(t.err[0], std::min(t.err[1], t.err[2]));
+        }
+    }
+
+    // A vertex is on the border if it shares a single triangle with any
+    // vertex of its fan, itself included
+    void updateBorders()
+    {
+        const int vc = int(vertices.size());
+
+        #pragma omp parallel
+        {
+            std::vector<int> vcount, vids;
 
-            for (auto& v : vertices)
+            #pragma omp for
+            for (int i = 0; i < vc; ++i)
             {
+                auto& v = vertices[i];
                 vcount.clear();
                 vids.clear();
                 for (int j = 0; j < v.tcount; ++j)
                 {
-                    int k   = refs[v.tstart + j].tid;
-                    auto& t = triangles[k];
+                    const auto& t = triangles[refs[v.tstart + j].tid];
                     for (int k = 0; k < 3; ++k)
                     {
                         int ofs = 0, id = t.v[k];
@@ -400,9 +567,8 @@ struct Simplifier
                             ++vcount[ofs];
                     }
                 }
-                for (int j = 0, c = int(vcount.size()); j < c; ++j)
-                    if(vcount[j] == 1)
-                        vertices[vids[j]].border = 1;
+                v.border = std::find(vcount.begin(), vcount.end(), 1) !=
+                           vcount.end();
             }
         }
     }
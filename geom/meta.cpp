@@ -0,0 +1,61 @@
+#include "meta.h"
+
+#include <string>
+
+#include "constants.h"
+
+namespace pt
+{
+namespace geom
+{
+
+Meta Meta::parse(const json& meta)
+{
+    Meta geom;
+    geom.scale  = meta.value(c::object::meta::SCALE, 1.f);
+    geom.mesher = meta.value(c::object::meta::MESHER, std::string()) ==
+                  "surfacenets" ? Mesher::SurfaceNets : Mesher::Greedy;
+    {
+        // Smooth deformer
+        const auto it = meta.find(c::object::meta::SMOOTH);
+        if (it != meta.end())
+        {
+            const auto smooth = *it;
+            if (smooth.is_number_integer())
+                geom.smooth.iterations = smooth;
+            else
+            if (smooth.is_array())
+            {
+                geom.smooth.iterations = smooth[0];
+                geom.smooth.strength   = smooth[1];
+            }
+        }
+    }
+    {
+        // Simplify deformer
+        const auto it = meta.find(c::object::meta::SIMPLIFY);
+        if (it != meta.end())
+        {
+            const auto simplify = *it;
+            if (simplify.is_number_integer())
+                geom.simplify.iterations = simplify;
+            else
+            if (simplify.is_array())
+            {
+                geom.simplify.iterations = simplify[0];
+                geom.simplify.strength   = simplify[1];
+                geom.simplify.scale      = simplify[2];
+            }
+            else
+            if (simplify.is_object())
+            {
+                geom.simplify.target = simplify.value("target", 0.f);
+                geom.simplify.error  = simplify.value("error",  0.f);
+            }
+        }
+    }
+    return geom;
+}
+
+} // namespace geom
+} // namespace pt
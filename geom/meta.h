@@ -2,6 +2,8 @@
 
 #include <glm/vec3.hpp>
 
+#include "common/json.h"
+
 namespace pt
 {
 namespace geom
@@ -23,24 +25,45 @@ struct Smooth
 
 struct Simplify
 {
-    Simplify() :  iterations(5), strength(0.01f), scale(2.f)
+    Simplify() :  iterations(5), strength(0.01f), scale(2.f),
+                  target(0.f), error(0.f)
     {}
 
     operator bool() const
     {
-        return iterations > 0;
+        return iterations > 0 || queued();
+    }
+
+    // Collapse by increasing error down to a fraction of the triangles
+    // and/or up to an error bound, instead of threshold iterations
+    bool queued() const
+    {
+        return target > 0.f || error > 0.f;
     }
 
     int   iterations;
     float strength;
     float scale;
+    float target;
+    float error;
+};
+
+// Mesher of smooth objects
+enum class Mesher
+{
+    Greedy,     // Box faces, then the smooth deformer
+    SurfaceNets // Surface nets, skipping the smooth deformer
 };
 
 struct Meta
 {
     Meta() = default;
 
-    float    scale = 1.f;
+    // Geometry settings of an object metafile
+    static Meta parse(const json& meta);
+
+    float    scale  = 1.f;
+    Mesher   mesher = Mesher::Greedy;
     Smooth   smooth;
     Simplify simplify;
 };
@@ -0,0 +1,116 @@
+#include "occupancy.h"
+
+#include <algorithm>
+
+#include "common/common.h"
+
+#include "volume.h"
+
+namespace pt
+{
+
+Occupancy::Occupancy() :
+    width(0), height(0), depth(0), stride(0)
+{}
+
+Occupancy::Occupancy(const ImageCube& imageCube) :
+    Occupancy()
+{
+    const Cubefield cfield(imageCube);
+    const auto& hf = cfield.hfields;
+
+    width  = cfield.width;
+    height = cfield.height;
+    depth  = cfield.depth;
+    stride = (width + WORD_BITS - 1) / WORD_BITS;
+    bits.assign(stride * height * depth, 0);
+
+    for (int z = 0; z < depth; ++z)
+        for (int y = 0; y < height; ++y)
+        {
+            Word* r = &bits[(z * height + y) * stride];
+
+            // Left and right fields bound the row to a single span
+            const int x0 = std::max(0,     width - hf[3].f(z, y));
+            const int x1 = std::min(width, hf[2].f(z, y));
+
+            for (int x = x0; x < x1; ++x)
+                if (hf[0].f(x, y) > z && hf[1].f(x, y) > depth  - z - 1 &&
+                    hf[4].f(x, z) > y && hf[5].f(x, z) > height - y - 1)
+                    r[x / WORD_BITS] |= Word(1) << (x % WORD_BITS);
+        }
+
+    // Surface voxels, whose six neighbors are not all occupied. A field's
+    // gradient is zero below its top voxel, so the others have none.
+    surface.assign(bits.size(), 0);
+    offsets.assign(bits.size(), 0);
+
+    uint32_t count = 0;
+    for (int z = 0; z < depth; ++z)
+        for (int y = 0; y < height; ++y)
+        {
+            const std::size_t base    = std::size_t(z * height + y) * stride;
+            const Word*       r       = row(y, z);
+            const Word*       rows[4] = {row(y - 1, z), row(y + 1, z),
+                                         row(y, z - 1), row(y, z + 1)};
+
+            for (int i = 0; i < stride; ++i)
+            {
+                // Neighbors along X shift in the bits of adjacent words
+                Word inner = r[i] & (r[i] << 1 | (i > 0 ?
+                                     r[i - 1] >> (WORD_BITS - 1) : 0))
+                                  & (r[i] >> 1 | (i + 1 < stride ?
+                                     r[i + 1] << (WORD_BITS - 1) : 0));
+                for (const Word* n : rows)
+                    inner &= n ? n[i] : 0;
+
+                surface[base + i] = r[i] & ~inner;
+                offsets[base + i] = count;
+                count += uint32_t(popcount(surface[base + i]));
+            }
+        }
+
+    gradients.resize(3 * std::size_t(count));
+    #pragma omp parallel for schedule(dynamic)
+    for (int z = 0; z < depth; ++z)
+        for (int y = 0; y < height; ++y)
+        {
+            const std::size_t base = std::size_t(z * height + y) * stride;
+            for (int i = 0; i < stride; ++i)
+            {
+                uint8_t* p = &gradients[3 * std::size_t(offsets[base + i])];
+                for (Word s = surface[base + i]; s; s &= s - 1, p += 3)
+                {
+                    const int x = i * WORD_BITS + ctz(s);
+                    const int g = cfield.g(x, y, z);
+                    p[0] = uint8_t(g);
+                    p[1] = uint8_t(g >> 8);
+                    p[2] = uint8_t(g >> 16);
+                }
+            }
+        }
+}
+
+int Occupancy::count(const Word* row, int x0, int x1) const
+{
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, width - 1);
+    if (!row || x0 > x1)
+        return 0;
+
+    const int  w0 = x0 / WORD_BITS;
+    const int  w1 = x1 / WORD_BITS;
+    const Word m0 = ~Word(0) << (x0 % WORD_BITS);
+    const Word m1 = ~Word(0) >> (WORD_BITS - 1 - x1 % WORD_BITS);
+
+    if (w0 == w1)
+        return popcount(row[w0] & m0 & m1);
+
+    int n = popcount(row[w0] & m0);
+    for (int i = w0 + 1; i < w1; ++i)
+        n += popcount(row[i]);
+
+    return n + popcount(row[w1] & m1);
+}
+
+} // namespace pt
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "common/common.h"
+#include "img/image_cube.h"
+
+namespace pt
+{
+
+// Bit-packed solid volume, 64 voxels per word along X. Collapse gradients
+// are only set on voxels with an empty neighbor, so they are stored for
+// those surface voxels alone, 24 bits each and indexed by the rank of the
+// voxel in a surface bit volume.
+struct Occupancy
+{
+    using Word = uint64_t;
+    static constexpr int WORD_BITS = 64;
+
+    Occupancy();
+    explicit Occupancy(const ImageCube& imageCube);
+
+    operator bool() const
+    {
+        return !bits.empty();
+    }
+
+    inline const Word* row(int y, int z) const
+    {
+        return y >= 0 && y < height && z >= 0 && z < depth ?
+               &bits[(z * height + y) * stride] : nullptr;
+    }
+
+    inline bool operator()(int x, int y, int z) const
+    {
+        const Word* r = x >= 0 && x < width ? row(y, z) : nullptr;
+        return r && ((r[x / WORD_BITS] >> (x % WORD_BITS)) & 1);
+    }
+
+    inline int g(int x, int y, int z) const
+    {
+        const std::size_t w = std::size_t(z * height + y) * stride +
+                              x / WORD_BITS;
+        const Word        m = Word(1) << (x % WORD_BITS);
+        if (!(surface[w] & m))
+            return 0;
+
+        const uint8_t* p = &gradients[3 * (offsets[w] +
+                                           popcount(surface[w] & (m - 1)))];
+        return p[0] | p[1] << 8 | p[2] << 16;
+    }
+
+    inline glm::vec3 size() const
+    {
+        return {width, height, depth};
+    }
+
+    // Number of occupied voxels of a row within [x0, x1]
+    int count(const Word* row, int x0, int x1) const;
+
+    int width, height, depth, stride;
+    std::vector<Word>     bits;
+    std::vector<Word>     surface;   // Occupied voxels with an empty neighbor
+    std::vector<uint32_t> offsets;   // Surface voxels before each word
+    std::vector<uint8_t>  gradients; // 24-bit gradients of surface voxels
+};
+
+} // namespace pt
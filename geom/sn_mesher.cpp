@@ -0,0 +1,255 @@
+#include "sn_mesher.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "mesh_common.h"
+
+namespace pt
+{
+namespace SnMesher
+{
+
+namespace
+{
+
+// Cell layers meshed per task
+constexpr int SLAB = 8;
+
+struct EdgeTable
+{
+    int cubeEdges[24] = {0};
+    int edges[256]    = {0};
+
+    EdgeTable()
+    {
+        // Corner pairs of the cube edges, the first three along X, Y and Z
+        int k = 0;
+        for (int i = 0; i < 8; ++i)
+            for (int j = 1; j <= 4; j <<= 1)
+            {
+                const int p = i ^ j;
+                if (i <= p)
+                {
+                    cubeEdges[k++] = i;
+                    cubeEdges[k++] = p;
+                }
+            }
+
+        // Edges crossing the surface for each corner configuration
+        for (int i = 0; i < 256; ++i)
+        {
+            int em = 0;
+            for (int j = 0; j < 24; j += 2)
+            {
+                const int a = !(i & (1 << cubeEdges[j]));
+                const int b = !(i & (1 << cubeEdges[j + 1]));
+                em |= a != b ? (1 << (j >> 1)) : 0;
+            }
+            edges[i] = em;
+        }
+    }
+};
+
+const EdgeTable edgeTable;
+
+// Cell grid of the volume padded by one voxel. Cell (x, y, z) has the
+// voxels (x - 1, y - 1, z - 1) to (x, y, z) as its corners.
+struct Cells
+{
+    explicit Cells(const Occupancy& occupancy) :
+        w(occupancy.width + 1), h(occupancy.height + 1),
+        d(occupancy.depth + 1),
+        masks(std::size_t(w) * h * d),
+        indices(masks.size()),
+        slabs((d + SLAB - 1) / SLAB)
+    {}
+
+    int index(int x, int y, int z) const
+    {
+        return (z * h + y) * w + x;
+    }
+
+    const glm::vec3& vertex(int x, int y, int z) const
+    {
+        return slabs[z / SLAB][indices[index(x, y, z)]];
+    }
+
+    int w, h, d;
+    std::vector<uint8_t>                masks;
+    std::vector<int>                    indices;
+    std::vector<std::vector<glm::vec3>> slabs;
+};
+
+// Corner masks and vertices of the cells of a slab
+void placeVertices(const Occupancy& occupancy, Cells& cells, int slab)
+{
+    auto& vertices = cells.slabs[slab];
+    const int z1   = std::min(cells.d, (slab + 1) * SLAB);
+    for (int z = slab * SLAB; z < z1; ++z)
+        for (int y = 0; y < cells.h; ++y)
+            for (int x = 0; x < cells.w; ++x)
+            {
+                int mask = 0;
+                for (int g = 0; g < 8; ++g)
+                    mask |= occupancy(x + (g & 1) - 1,
+                                      y + ((g >> 1) & 1) - 1,
+                                      z + ((g >> 2) & 1) - 1) << g;
+
+                const int c = cells.index(x, y, z);
+                cells.masks[c] = uint8_t(mask);
+                if (mask == 0 || mask == 0xff)
+                    continue;
+
+                // Average of the crossed edge midpoints, relative to the
+                // voxel centers of the corners
+                const int edgeMask = edgeTable.edges[mask];
+                glm::vec3 v(0.f);
+                int count = 0;
+                for (int i = 0; i < 12; ++i)
+                    if (edgeMask & (1 << i))
+                    {
+                        const int e0 = edgeTable.cubeEdges[2 * i + 0];
+                        const int e1 = edgeTable.cubeEdges[2 * i + 1];
+                        for (int j = 0; j < 3; ++j)
+                            v[j] += 0.5f * (((e0 >> j) & 1) + ((e1 >> j) & 1));
+                        ++count;
+                    }
+
+                cells.indices[c] = int(vertices.size());
+                vertices.push_back(glm::vec3(x, y, z) - 0.5f + v / float(count));
+            }
+}
+
+// Quads around the crossed edges leading into the cells of a slab
+void emitFaces(const Occupancy& occupancy,
+               const Cells& cells,
+               const RectCube<float>& uvCube,
+               float scale, int slab,
+               Mesh_P_N_T_UV& mesh)
+{
+    const int axisUV[6][2] =
+    {
+        {2, 1}, {2, 1},
+        {0, 2}, {0, 2},
+        {0, 1}, {0, 1},
+    };
+    const int axisSide[6] = {2, 3, 5, 4, 1, 0};
+    const auto size       = occupancy.size();
+
+    const auto uvOf = [&](int axis, const glm::vec3& p)
+    {
+        const int u = axisUV[axis][0], v = axisUV[axis][1];
+        return uvCube[axisSide[axis]].point(p[u] / size[u], p[v] / size[v]);
+    };
+
+    const int z1 = std::min(cells.d, (slab + 1) * SLAB);
+    for (int z = slab * SLAB; z < z1; ++z)
+        for (int y = 0; y < cells.h; ++y)
+            for (int x = 0; x < cells.w; ++x)
+            {
+                const int mask = cells.masks[cells.index(x, y, z)];
+                if (mask == 0 || mask == 0xff)
+                    continue;
+
+                const int c[3] = {x, y, z};
+                for (int i = 0; i < 3; ++i)
+                {
+                    // Edge from the first corner along the axis
+                    if (((mask >> (1 << i)) & 1) == (mask & 1))
+                        continue;
+
+                    const int iu = (i + 1) % 3;
+                    const int iv = (i + 2) % 3;
+                    if (c[iu] == 0 || c[iv] == 0)
+                        continue;
+
+                    int cu[3] = {x, y, z}, cv[3] = {x, y, z},
+                        cw[3] = {x, y, z};
+                    --cu[iu];
+                    --cv[iv];
+                    --cw[iu];
+                    --cw[iv];
+
+                    // Cells below the slab were placed by the previous one
+                    const auto va = cells.vertex(x, y, z);
+                    const auto vb = cells.vertex(cu[0], cu[1], cu[2]);
+                    const auto vc = cells.vertex(cw[0], cw[1], cw[2]);
+                    const auto vd = cells.vertex(cv[0], cv[1], cv[2]);
+
+                    // Solid first corner faces along the axis
+                    const int  axis = 2 * i + (mask & 1);
+                    const auto v    = (mask & 1) ?
+                                      std::array<glm::vec3, 4>{va, vb, vc, vd} :
+                                      std::array<glm::vec3, 4>{vc, vb, va, vd};
+                    std::array<glm::vec2, 4> uv;
+                    for (int k = 0; k < 4; ++k)
+                        uv[k] = uvOf(axis, v[k]);
+
+                    if (glm::length2(v[0] - v[2]) < glm::length2(v[1] - v[3]))
+                    {
+                        emitTri(&mesh, {scale * v[0], scale * v[1], scale * v[2]},
+                                       {uv[0], uv[1], uv[2]});
+                        emitTri(&mesh, {scale * v[2], scale * v[3], scale * v[0]},
+                                       {uv[2], uv[3], uv[0]});
+                    }
+                    else
+                    {
+                        emitTri(&mesh, {scale * v[1], scale * v[2], scale * v[3]},
+                                       {uv[1], uv[2], uv[3]});
+                        emitTri(&mesh, {scale * v[3], scale * v[0], scale * v[1]},
+                                       {uv[3], uv[0], uv[1]});
+                    }
+                }
+            }
+}
+
+} // namespace
+
+Mesh_P_N_T_UV mesh(const Occupancy& occupancy,
+                   const RectCube<float>& uvCube,
+                   float scale)
+{
+    if (!occupancy)
+        return Mesh_P_N_T_UV();
+
+    Cells cells(occupancy);
+    const int slabCount = int(cells.slabs.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < slabCount; ++s)
+        placeVertices(occupancy, cells, s);
+
+    std::vector<Mesh_P_N_T_UV> meshes(slabCount);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < slabCount; ++s)
+        emitFaces(occupancy, cells, uvCube, scale, s, meshes[s]);
+
+    // Stitch the slabs in order
+    std::size_t vertexCount = 0, indexCount = 0;
+    for (const auto& m : meshes)
+    {
+        vertexCount += m.vertices.size();
+        indexCount  += m.indices.size();
+    }
+
+    Mesh_P_N_T_UV mesh;
+    mesh.vertices.reserve(vertexCount);
+    mesh.indices.reserve(indexCount);
+    for (const auto& m : meshes)
+    {
+        const auto base = Mesh_P_N_T_UV::Index(mesh.vertices.size());
+        mesh.vertices.insert(mesh.vertices.end(),
+                             m.vertices.begin(), m.vertices.end());
+        for (const auto i : m.indices)
+            mesh.indices.push_back(base + i);
+    }
+    return mesh;
+}
+
+} // namespace SnMesher
+} // namespace pt
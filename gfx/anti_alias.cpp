@@ -1,12 +1,13 @@
 #include "anti_alias.h"
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
 
-AntiAlias::AntiAlias(const Size<int>& renderSize) :
+AntiAlias::AntiAlias(const Size<int>& renderSize, FrameGraph& graph) :
     renderSize(renderSize),
     rect(squareMesh()),
     vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
@@ -15,10 +16,7 @@ AntiAlias::AntiAlias(const Size<int>& renderSize) :
         {{0, "position"}, {1, "uv"}})
 {
     // Texture and FBO
-    auto fboSize = {renderSize.w, renderSize.h};
-    tex.bind().alloc(fboSize, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)
-              .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-              .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    tex = graph.texture("aa");
     fbo.bind()
        .attach(tex, gl::Fbo::Attachment::Color)
        .unbind();
@@ -30,7 +28,7 @@ AntiAlias& AntiAlias::operator()(gl::Texture* texColor)
     prog.bind().setUniform("tex", 0);
     glViewport(0, 0, renderSize.w, renderSize.h);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     texColor->bindAs(GL_TEXTURE0);
     rect.render();
     return* this;
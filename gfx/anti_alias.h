@@ -6,6 +6,8 @@
 #include "gl/texture.h"
 #include "gl/fbo.h"
 
+#include "frame_graph.h"
+
 namespace pt
 {
 namespace gfx
@@ -24,7 +26,7 @@ struct AntiAlias
     gl::Texture       tex;
     gl::Fbo           fbo;
 
-    AntiAlias(const Size<int>& renderSize);
+    AntiAlias(const Size<int>& renderSize, FrameGraph& graph);
 
     AntiAlias& operator()(gl::Texture* texColor);
 
@@ -5,6 +5,7 @@
 #include "constants.h"
 
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -23,7 +24,7 @@ Arrow& Arrow::operator()(gl::Fbo* fboOut, const glm::mat4& mvp)
 {
     Binder<gl::Fbo> binder(fboOut);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
 
     const auto t = glm::translate(glm::vec3(c::cell::SIZE.x, 0.f, 0.f));
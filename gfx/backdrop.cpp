@@ -1,6 +1,7 @@
 #include "backdrop.h"
 
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -20,21 +21,17 @@ Backdrop::Backdrop(const Size<int>& renderSize) :
               .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-Backdrop& Backdrop::operator()(gl::Fbo* fboOut, const Camera& camera)
+Backdrop& Backdrop::operator()(gl::Fbo* fboOut)
 {
     Binder<gl::Fbo> binder(fboOut);
     prog.bind()
-        .setUniform("tex",         0)
-        .setUniform("v",           camera.matrixView())
-        .setUniform("pos",         camera.position())
-        .setUniform("z",           1.f)
-        .setUniform("tanHalfFov",  camera.tanHalfFov())
-        .setUniform("aspectRatio", camera.ar)
-        .setUniform("gridColor",   glm::vec4(0, 0.5, 0, 1));
+        .setUniform("tex",       0)
+        .setUniform("z",         1.f)
+        .setUniform("gridColor", glm::vec4(0, 0.5, 0, 1));
 
     glViewport(0, 0, renderSize.w, renderSize.h);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glEnable(GL_DEPTH_TEST);
+    gl::State::enable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
     glDepthMask(GL_FALSE);
 
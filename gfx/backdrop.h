@@ -29,7 +29,7 @@ struct Backdrop
 
     Backdrop(const Size<int>& renderSize);
 
-    Backdrop& operator()(gl::Fbo* fboOut, const Camera& camera);
+    Backdrop& operator()(gl::Fbo* fboOut);
 };
 
 } // namespace gfx
@@ -1,14 +1,17 @@
 #include "bloom.h"
 
+#include <string>
+
 #include "common/log.h"
 #include "geom/mesh.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
 
-Bloom::Bloom(const Size<int>& renderSize) :
+Bloom::Bloom(const Size<int>& renderSize, FrameGraph& graph) :
     renderSize(renderSize),
     rect(squareMesh()),
     vsQuadUv(gl::Shader::path("quad_uv.vs.glsl")),
@@ -26,40 +29,31 @@ Bloom::Bloom(const Size<int>& renderSize) :
             {{0, "position"}, {1, "uv"}})
 {
     PTLOG(Info) << "size " << renderSize.w << "x" << renderSize.h;
-    auto fboSize = {renderSize.w, renderSize.h};
-
-    const GLenum iformat = GL_RGB16F;
-    const GLenum type    = GL_FLOAT;
 
     // Color + emission texture and FBO
-    texBloom.bind().alloc(fboSize, iformat, GL_RGB, type)
-                   .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                   .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texBloom = graph.texture("bloom");
     fboBloom.bind()
             .attach(texBloom, gl::Fbo::Attachment::Color)
             .unbind();
 
     for (int i = 0; i < scaleCount; ++i)
     {
-        const Size<int> size = renderSize / (2 << i);
-        auto sizeScaled      = {size.w, size.h};
-
-        texScale[i].bind().alloc(sizeScaled, iformat, GL_RGB, type)
-                          .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                          .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        texAdd[i].bind().alloc(sizeScaled, iformat, GL_RGB, type)
-                        .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                        .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        texBlur[i].bind().alloc(sizeScaled, iformat, GL_RGB, type)
-                         .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                         .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        const auto n = std::to_string(i);
+        texScale[i]  = graph.texture("bloom-scale" + n);
+        texBlur[i]   = graph.texture("bloom-blur"  + n);
 
         fboScale[i].bind()
                    .attach(texScale[i], gl::Fbo::Attachment::Color)
                    .unbind();
-        fboAdd[i].bind()
-                 .attach(texAdd[i], gl::Fbo::Attachment::Color)
-                 .unbind();
+
+        // The coarsest scale has nothing to add
+        if (i < scaleCount - 1)
+        {
+            texAdd[i] = graph.texture("bloom-add" + n);
+            fboAdd[i].bind()
+                     .attach(texAdd[i], gl::Fbo::Attachment::Color)
+                     .unbind();
+        }
         fboBlur[i].bind()
                   .attach(texBlur[i], gl::Fbo::Attachment::Color)
                   .unbind();
@@ -69,7 +63,7 @@ Bloom::Bloom(const Size<int>& renderSize) :
 Bloom& Bloom::operator()(gl::Texture* texColor)
 {
     // Setup common GL states
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
 
     // Produce bloom bright map
     progBloom.bind().setUniform("texColor",  0);
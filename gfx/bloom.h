@@ -8,6 +8,8 @@
 #include "gl/texture.h"
 #include "gl/fbo.h"
 
+#include "frame_graph.h"
+
 namespace pt
 {
 namespace gfx
@@ -42,7 +44,7 @@ struct Bloom
                       fboAdd[scaleCount],
                       fboBlur[scaleCount];
 
-    Bloom(const Size<int>& renderSize);
+    Bloom(const Size<int>& renderSize, FrameGraph& graph);
 
     Bloom& operator()(gl::Texture* texColor);
 
@@ -5,30 +5,45 @@
 #include "gl/primitive.h"
 #include "gl/shaders.h"
 #include "gl/fbo.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
+namespace
+{
+
+gl::Texture blurTexture(const Size<int>& size)
+{
+    // TODO: Configurable pixel type
+    gl::Texture tex;
+    tex.bind().alloc({size.w, size.h}, GL_RGBA16F, GL_RGBA, GL_FLOAT)
+              .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
+              .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return tex;
+}
+
+} // namespace
 
 struct Blur::Data
 {
     Data(const Size<int>& size, gl::Texture* out, int level, bool bilateral) :
+        Data(size, blurTexture(size), blurTexture(size), out, level, bilateral)
+    {}
+
+    Data(const Size<int>& size,
+         const gl::Texture& tex0, const gl::Texture& tex1,
+         gl::Texture* out, int level, bool bilateral) :
         size(size),
         rect(squareMesh()),
+        texBlur{tex0, tex1},
         vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
         fsBlur(gl::Shader::path(bilateral ? "blur_bi.fs.glsl" : "blur.fs.glsl")),
         prog({vsQuad, fsBlur}, {{0, "position"}, {1, "uv"}}),
         out(out),
         level(level)
-    {
-        // TODO: Configurable pixel type
-        auto dim = {size.w, size.h};
-        for (int i = 0; i < 2; ++i)
-            texBlur[i].bind().alloc(dim, GL_RGBA16F, GL_RGBA, GL_FLOAT)
-                             .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                             .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
+    {}
 
     Size<int>         size;
     gl::Primitive     rect;
@@ -52,6 +67,11 @@ Blur::Blur(const Size<int>& size, gl::Texture* out, int level, bool bilateral) :
     d(std::make_shared<Data>(size, out, level, bilateral))
 {}
 
+Blur::Blur(const Size<int>& size, const gl::Texture& tex0,
+           const gl::Texture& tex1, bool bilateral) :
+    d(std::make_shared<Data>(size, tex0, tex1, nullptr, 0, bilateral))
+{}
+
 Blur& Blur::operator()(gl::Texture* tex, gl::Texture* texDepth,
                        int radius, float sharpness)
 {
@@ -64,7 +84,7 @@ Blur& Blur::operator()(gl::Texture* tex, gl::Texture* texDepth,
     const Size<int> size(d->size);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
     glViewport(0, 0, size.w, size.h);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
 
     for (int i = 0; i < 2; ++i)
@@ -20,6 +20,10 @@ struct Blur
     Blur(const Size<int>& size, gl::Texture* out, int level,
          bool bilateral = false);
 
+    // Blurs through the given textures of the size, output last
+    Blur(const Size<int>& size, const gl::Texture& tex0,
+         const gl::Texture& tex1, bool bilateral = false);
+
     Blur& operator()(gl::Texture* tex, gl::Texture* texDepth,
                      int radius, float sharpness = 1.f);
 
@@ -1,13 +1,14 @@
 #include "color_grade.h"
 
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
 
-ColorGrade::ColorGrade(const Size<int>& renderSize) :
+ColorGrade::ColorGrade(const Size<int>& renderSize, FrameGraph& graph) :
     renderSize(renderSize),
     rect(squareMesh()),
     vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
@@ -16,10 +17,7 @@ ColorGrade::ColorGrade(const Size<int>& renderSize) :
         {{0, "position"}, {1, "uv"}})
 {
     // Texture and FBO
-    auto fboSize = {renderSize.w, renderSize.h};
-    tex.bind().alloc(fboSize, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)
-              .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-              .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    tex = graph.texture("graded");
     fbo.bind()
        .attach(tex, gl::Fbo::Attachment::Color)
        .unbind();
@@ -32,7 +30,7 @@ ColorGrade& ColorGrade::operator()(gl::Texture* texColor, gl::Texture* texBloom)
                .setUniform("tex1", 1);
     glViewport(0, 0, renderSize.w, renderSize.h);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     texColor->bindAs(GL_TEXTURE0);
     texBloom->bindAs(GL_TEXTURE1);
     rect.render();
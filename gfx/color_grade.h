@@ -6,6 +6,8 @@
 #include "gl/texture.h"
 #include "gl/fbo.h"
 
+#include "frame_graph.h"
+
 namespace pt
 {
 namespace gfx
@@ -24,7 +26,7 @@ struct ColorGrade
     gl::Texture       tex;
     gl::Fbo           fbo;
 
-    ColorGrade(const Size<int>& renderSize);
+    ColorGrade(const Size<int>& renderSize, FrameGraph& graph);
 
     ColorGrade& operator()(gl::Texture* texColor, gl::Texture* texBloom);
 
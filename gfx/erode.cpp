@@ -6,6 +6,7 @@
 #include "gl/primitive.h"
 #include "gl/shaders.h"
 #include "gl/fbo.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -49,7 +50,7 @@ Erode& Erode::operator()(gl::Texture* tex, int radius)
     const Size<int> size(d->size);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
     glViewport(0, 0, size.w, size.h);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
 
     for (int i = 0; i < 2; ++i)
@@ -2,6 +2,8 @@
 
 #include <glm/vec4.hpp>
 
+#include "gl/state.h"
+
 namespace pt
 {
 namespace gfx
@@ -18,11 +20,11 @@ Fader::Fader() :
 
 Fader& Fader::operator()(float alpha)
 {
-    glEnable(GL_BLEND);
+    gl::State::enable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     prog.bind().setUniform("albedo", glm::vec4(0, 0, 0, alpha));
     rect.render();
-    glDisable(GL_BLEND);
+    gl::State::disable(GL_BLEND);
     return* this;
 }
 
@@ -0,0 +1,120 @@
+#include "frame.h"
+
+#include <string>
+
+#include "bloom.h"
+
+namespace pt
+{
+namespace gfx
+{
+
+FrameGraph frame(const Size<int>& renderSize, const cfg::Video& config)
+{
+    using Target = FrameGraph::Target;
+
+    const auto ssaoSize = renderSize * config.ssao.scale;
+    const auto scSize   = renderSize * config.sc.scale;
+    const auto ssrSize  = renderSize * config.ssr.scale;
+    const bool scBlur   = scSize.w < renderSize.w;
+
+    FrameGraph graph;
+    graph.persistent("depth")
+         .persistent("env");
+
+    // G-buffer
+    graph.target("normal",         {renderSize, GL_RGB16F,  GL_RGB,
+                                    GL_FLOAT, 0})
+         .target("normal-denoise", {renderSize, GL_RGB16F,  GL_RGB,
+                                    GL_FLOAT, GL_LINEAR})
+         .target("color",          {renderSize, GL_RGB8,    GL_RGB,
+                                    GL_UNSIGNED_BYTE, 0})
+         .target("light",          {renderSize, GL_RGBA8,   GL_RGBA,
+                                    GL_UNSIGNED_BYTE, 0})
+         .target("probe",          {renderSize, GL_RGBA16F, GL_RGBA,
+                                    GL_FLOAT, 0})
+         .target("depth-linear",   {renderSize, GL_R32F,    GL_RED,
+                                    GL_FLOAT, GL_LINEAR});
+
+    // Lighting
+    graph.target("ao",        {ssaoSize, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 0})
+         .target("ao-blur0",  {ssaoSize, GL_RGBA16F, GL_RGBA, GL_FLOAT,
+                               GL_LINEAR})
+         .target("ao-blur1",  {ssaoSize, GL_RGBA16F, GL_RGBA, GL_FLOAT,
+                               GL_LINEAR})
+         .target("sc",        {scSize, GL_RGB16F, GL_RGB, GL_FLOAT,
+                               GL_LINEAR})
+         .target("lit",       {renderSize, GL_RGB16F, GL_RGB, GL_FLOAT,
+                               GL_LINEAR});
+    if (scBlur)
+        graph.target("sc-blur0", {scSize, GL_RGBA16F, GL_RGBA, GL_FLOAT,
+                                  GL_LINEAR})
+             .target("sc-blur1", {scSize, GL_RGBA16F, GL_RGBA, GL_FLOAT,
+                                  GL_LINEAR});
+
+    // Reflections and transparency
+    graph.target("ssr-uva", {ssrSize, GL_RGB16F, GL_RGB, GL_FLOAT, GL_LINEAR})
+         .target("ssr",     {renderSize, GL_RGB16F, GL_RGB, GL_FLOAT, 0})
+         .target("oit0",    {renderSize, GL_RGBA16F, GL_RGBA, GL_FLOAT, 0})
+         .target("oit1",    {renderSize, GL_R16F, GL_RED, GL_FLOAT, 0})
+         .target("comp",    {renderSize, GL_RGB16F, GL_RGB, GL_FLOAT,
+                             GL_LINEAR});
+
+    // Post-processing
+    FrameGraph::Names bloomWrites = {"bloom"};
+    graph.target("bloom", {renderSize, GL_RGB16F, GL_RGB, GL_FLOAT,
+                           GL_LINEAR});
+    for (int i = 0; i < Bloom::scaleCount; ++i)
+    {
+        const auto n      = std::to_string(i);
+        const auto target = Target{renderSize / (2 << i), GL_RGB16F, GL_RGB,
+                                   GL_FLOAT, GL_LINEAR};
+        graph.target("bloom-scale" + n, target)
+             .target("bloom-blur"  + n, target);
+        bloomWrites.push_back("bloom-scale" + n);
+        bloomWrites.push_back("bloom-blur"  + n);
+
+        // The coarsest scale has nothing to add
+        if (i < Bloom::scaleCount - 1)
+        {
+            graph.target("bloom-add" + n, target);
+            bloomWrites.push_back("bloom-add" + n);
+        }
+    }
+    graph.target("graded", {renderSize, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+                            GL_LINEAR})
+         .target("aa",     {renderSize, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+                            GL_LINEAR});
+
+    // Passes
+    const auto scOut = scBlur ? "sc-blur1" : "sc";
+    graph.pass("geom-opq",    {},
+                              {"depth", "normal", "normal-denoise", "color",
+                               "light", "probe", "depth-linear"})
+         .pass("ssao",        {"depth-linear", "normal-denoise"},
+                              {"ao", "ao-blur0", "ao-blur1"})
+         .pass("lighting-sc", {"depth"},
+                              scBlur ? FrameGraph::Names{"sc", "sc-blur0",
+                                                         "sc-blur1"} :
+                                       FrameGraph::Names{"sc"})
+         .pass("lighting",    {"depth", "normal-denoise", "color", "light",
+                               "probe", "ao-blur1", scOut},
+                              {"lit"})
+         .pass("env-mips",    {"lit", "depth"}, {"env"})
+         .pass("backdrop",    {"lit", "depth"}, {"lit"})
+         .pass("ssr",         {"depth-linear", "normal-denoise", "light",
+                               "lit", "env"},
+                              {"ssr-uva", "ssr"})
+         .pass("geom-tr",     {"ssr", "env", "depth"},
+                              {"oit0", "oit1", "comp"})
+         .pass("bloom",       {"comp"}, bloomWrites)
+         .pass("scene-ctrl",  {"comp"}, {"comp"})
+         .pass("colorgrade",  {"comp", "bloom-scale0"}, {"graded"})
+         .pass("anti-alias",  {"graded"}, {"aa"})
+         .pass("output",      {"aa"}, {});
+
+    return graph.compile();
+}
+
+} // namespace gfx
+} // namespace pt
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "common/config.h"
+#include "geom/size.h"
+
+#include "frame_graph.h"
+
+namespace pt
+{
+namespace gfx
+{
+
+// Targets and passes of a frame in execution order, compiled. Depth and the
+// environment mips are read across frames and stay with their passes.
+FrameGraph frame(const Size<int>& renderSize, const cfg::Video& config);
+
+} // namespace gfx
+} // namespace pt
@@ -0,0 +1,306 @@
+#include "frame_graph.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include "common/log.h"
+
+namespace pt
+{
+namespace gfx
+{
+namespace
+{
+
+std::size_t pixelBytes(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_R8:      return 1;
+        case GL_RG8:     return 2;
+        case GL_RGB8:    return 3;
+        case GL_RGBA8:   return 4;
+        case GL_R16F:    return 2;
+        case GL_RG16F:   return 4;
+        case GL_RGB16F:  return 6;
+        case GL_RGBA16F: return 8;
+        case GL_R32F:    return 4;
+        default:
+            throw std::runtime_error("Unsupported frame graph format " +
+                                     std::to_string(internalFormat));
+    }
+}
+
+std::size_t bytes(const FrameGraph::Target& target)
+{
+    return pixelBytes(target.internalFormat) * target.size.area();
+}
+
+bool sameLayout(const FrameGraph::Target& a, const FrameGraph::Target& b)
+{
+    return a.size           == b.size           &&
+           a.internalFormat == b.internalFormat &&
+           a.format         == b.format         &&
+           a.type           == b.type           &&
+           a.filter         == b.filter;
+}
+
+} // namespace
+
+struct FrameGraph::Data
+{
+    // Target and the first and last kept passes using it
+    struct Resource
+    {
+        FrameGraph::Target target;
+        bool               persistent;
+        int                first;
+        int                last;
+        int                texture;
+    };
+
+    struct Pass
+    {
+        std::string        name;
+        FrameGraph::Names  reads,
+                           writes;
+        FrameGraph::Run    run;
+        bool               kept;
+    };
+
+    std::map<std::string, Resource> resources;
+    std::vector<Pass>               passes;
+    std::vector<FrameGraph::Target> layouts;
+    std::map<int, gl::Texture>      textures;
+    bool                            compiled = false;
+
+    Resource& resource(const std::string& name)
+    {
+        const auto it = resources.find(name);
+        if (it == resources.end())
+            throw std::runtime_error("Unknown frame graph target " + name);
+        return it->second;
+    }
+
+    Pass& pass(const std::string& name)
+    {
+        const auto it = std::find_if(passes.begin(), passes.end(),
+            [&](const Pass& pass) { return pass.name == name; });
+        if (it == passes.end())
+            throw std::runtime_error("Unknown frame graph pass " + name);
+        return *it;
+    }
+
+    void cull()
+    {
+        // Back to front, a write satisfies the reads of later passes
+        std::set<std::string> needed;
+        for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass)
+        {
+            pass->kept = pass->writes.empty();
+            for (const auto& name : pass->writes)
+                pass->kept |= resource(name).persistent || needed.count(name);
+
+            if (pass->kept)
+            {
+                for (const auto& name : pass->writes)
+                    needed.erase(name);
+                for (const auto& name : pass->reads)
+                    needed.insert(name);
+            }
+        }
+        for (const auto& name : needed)
+            if (!resource(name).persistent)
+                throw std::runtime_error("Frame graph target " + name +
+                                         " is read before it is written");
+    }
+
+    void assign()
+    {
+        for (auto& resource : resources)
+        {
+            resource.second.first   = -1;
+            resource.second.last    = -1;
+            resource.second.texture = -1;
+        }
+        for (int i = 0; i < int(passes.size()); ++i)
+            if (passes[i].kept)
+                for (const auto* names : {&passes[i].reads, &passes[i].writes})
+                    for (const auto& name : *names)
+                    {
+                        auto& res = resource(name);
+                        res.first = res.first < 0 ? i : res.first;
+                        res.last  = i;
+                    }
+
+        // Used targets by first use, then unused ones, which never run and
+        // share with any texture of their layout
+        std::vector<Resource*> order;
+        for (auto& resource : resources)
+            if (!resource.second.persistent)
+                order.push_back(&resource.second);
+        std::stable_sort(order.begin(), order.end(),
+            [](const Resource* a, const Resource* b)
+            {
+                return unsigned(a->first) < unsigned(b->first);
+            });
+
+        layouts.clear();
+        textures.clear();
+        std::vector<int> freeAfter;
+        for (auto* resource : order)
+        {
+            for (int t = 0; t < int(layouts.size()); ++t)
+                if (sameLayout(layouts[t], resource->target) &&
+                    (resource->first < 0 || freeAfter[t] < resource->first))
+                {
+                    resource->texture = t;
+                    break;
+                }
+            if (resource->texture < 0)
+            {
+                resource->texture = int(layouts.size());
+                layouts.push_back(resource->target);
+                freeAfter.push_back(-1);
+            }
+            if (resource->first >= 0)
+                freeAfter[resource->texture] = resource->last;
+        }
+    }
+};
+
+FrameGraph::FrameGraph() :
+    d(std::make_shared<Data>())
+{}
+
+FrameGraph& FrameGraph::target(const std::string& name, const Target& target)
+{
+    d->resources[name] = {target, false, -1, -1, -1};
+    d->compiled        = false;
+    return *this;
+}
+
+FrameGraph& FrameGraph::persistent(const std::string& name)
+{
+    d->resources[name] = {Target(), true, -1, -1, -1};
+    d->compiled        = false;
+    return *this;
+}
+
+FrameGraph& FrameGraph::pass(const std::string& name,
+                             const Names& reads, const Names& writes)
+{
+    for (const auto* names : {&reads, &writes})
+        for (const auto& target : *names)
+            d->resource(target);
+
+    d->passes.push_back({name, reads, writes, Run(), true});
+    d->compiled = false;
+    return *this;
+}
+
+FrameGraph& FrameGraph::run(const std::string& pass, const Run& run)
+{
+    d->pass(pass).run = run;
+    return *this;
+}
+
+FrameGraph& FrameGraph::compile()
+{
+    d->cull();
+    d->assign();
+    d->compiled = true;
+
+    PTLOG(Info) << passes().size() << "/" << d->passes.size() << " passes, "
+                << textureCount() << "/" << targetCount() << " textures, "
+                << textureBytes() / (1 << 20) << "/"
+                << targetBytes() / (1 << 20) << " MiB";
+    return *this;
+}
+
+FrameGraph::Names FrameGraph::passes() const
+{
+    Names names;
+    for (const auto& pass : d->passes)
+        if (pass.kept)
+            names.push_back(pass.name);
+    return names;
+}
+
+FrameGraph::Names FrameGraph::culled() const
+{
+    Names names;
+    for (const auto& pass : d->passes)
+        if (!pass.kept)
+            names.push_back(pass.name);
+    return names;
+}
+
+FrameGraph& FrameGraph::operator()(const std::string& pass)
+{
+    const auto& run = d->pass(pass).run;
+    if (run)
+        run();
+    return *this;
+}
+
+gl::Texture FrameGraph::texture(const std::string& name)
+{
+    const auto& resource = d->resource(name);
+    if (resource.persistent)
+        throw std::runtime_error("Frame graph target " + name +
+                                 " is owned by its pass");
+    if (!d->compiled)
+        throw std::runtime_error("Frame graph is not compiled");
+
+    auto it = d->textures.find(resource.texture);
+    if (it == d->textures.end())
+    {
+        const auto& layout = d->layouts[resource.texture];
+        gl::Texture tex;
+        tex.bind().alloc({layout.size.w, layout.size.h},
+                         layout.internalFormat, layout.format, layout.type);
+        if (layout.filter)
+            tex.set(GL_TEXTURE_MIN_FILTER, layout.filter)
+               .set(GL_TEXTURE_MAG_FILTER, layout.filter);
+        tex.unbind();
+        it = d->textures.emplace(resource.texture, tex).first;
+    }
+    return it->second;
+}
+
+int FrameGraph::targetCount() const
+{
+    return int(std::count_if(d->resources.begin(), d->resources.end(),
+        [](const std::pair<const std::string, Data::Resource>& resource)
+        {
+            return !resource.second.persistent;
+        }));
+}
+
+int FrameGraph::textureCount() const
+{
+    return int(d->layouts.size());
+}
+
+std::size_t FrameGraph::targetBytes() const
+{
+    std::size_t sum = 0;
+    for (const auto& resource : d->resources)
+        if (!resource.second.persistent)
+            sum += bytes(resource.second.target);
+    return sum;
+}
+
+std::size_t FrameGraph::textureBytes() const
+{
+    std::size_t sum = 0;
+    for (const auto& layout : d->layouts)
+        sum += bytes(layout);
+    return sum;
+}
+
+} // namespace gfx
+} // namespace pt
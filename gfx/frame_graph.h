@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "geom/size.h"
+#include "gl/texture.h"
+
+namespace pt
+{
+namespace gfx
+{
+
+// Passes in execution order with the targets they read and write. Passes
+// whose writes are never read are culled, and transient targets whose
+// lifetimes over the kept passes are disjoint share a texture.
+struct FrameGraph
+{
+    // Layout of a transient 2D target, a zero filter keeps the default
+    struct Target
+    {
+        Size<int> size;
+        GLenum    internalFormat;
+        GLenum    format;
+        GLenum    type;
+        GLenum    filter;
+    };
+    using Names = std::vector<std::string>;
+    using Run   = std::function<void()>;
+
+    FrameGraph();
+
+    // Texture of the graph, undefined at the first pass writing it
+    FrameGraph& target(const std::string& name, const Target& target);
+    // Texture of a pass also read outside of the graph, never shared
+    FrameGraph& persistent(const std::string& name);
+
+    // Passes writing no target or a persistent one are never culled
+    FrameGraph& pass(const std::string& name,
+                     const Names& reads, const Names& writes);
+    FrameGraph& run(const std::string& pass, const Run& run);
+
+    // Culls passes and assigns textures to the targets
+    FrameGraph& compile();
+
+    // Kept and culled passes, in execution order
+    Names passes() const;
+    Names culled() const;
+
+    FrameGraph& operator()(const std::string& pass);
+
+    // Texture of a transient target, allocated on first use
+    gl::Texture texture(const std::string& name);
+
+    // Transient textures and their bytes, unshared and shared
+    int targetCount() const;
+    int textureCount() const;
+    std::size_t targetBytes() const;
+    std::size_t textureBytes() const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace gfx
+} // namespace pt
@@ -0,0 +1,77 @@
+#include "frame_uniforms.h"
+
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "gl/shaders.h"
+
+namespace pt
+{
+namespace gfx
+{
+namespace
+{
+
+// std140 layout of the Frame block in shaders/frame.glsl, mat3 columns
+// padded to vec4
+struct Block
+{
+    glm::mat4 v;
+    glm::mat4 p;
+    glm::mat4 w;
+    glm::vec4 n[3];
+    glm::vec4 clip;
+    glm::vec3 viewPos;
+    float     tanHalfFov;
+    glm::vec3 boundsMin;
+    float     aspectRatio;
+    glm::vec3 boundsSize;
+    float     time;
+    float     zNear;
+    float     zFar;
+    float     pad[2];
+};
+static_assert(sizeof(Block) == gl::FRAME_BLOCK_SIZE,
+              "Frame block layout mismatch");
+
+} // namespace
+
+FrameUniforms::FrameUniforms() :
+    buffer(gl::Buffer::Type::Uniform, gl::Buffer::Usage::DynamicDraw)
+{
+    buffer.alloc(nullptr, sizeof(Block));
+    buffer.bindBase(GLuint(gl::Block::Frame)).unbind();
+}
+
+FrameUniforms& FrameUniforms::operator()(const Camera& camera,
+                                         const Aabb& bounds, float time)
+{
+    const auto n = camera.matrixNormal();
+
+    Block block;
+    block.v           = camera.matrixView();
+    block.p           = camera.matrixProj();
+    block.w           = camera.matrixWorld();
+    block.n[0]        = glm::vec4(n[0], 0.f);
+    block.n[1]        = glm::vec4(n[1], 0.f);
+    block.n[2]        = glm::vec4(n[2], 0.f);
+    block.clip        = camera.infoClip();
+    block.viewPos     = camera.position();
+    block.tanHalfFov  = camera.tanHalfFov();
+    block.boundsMin   = glm::floor(bounds.min);
+    block.aspectRatio = camera.ar;
+    block.boundsSize  = glm::ceil(bounds.size());
+    block.time        = time;
+    block.zNear       = camera.zNear;
+    block.zFar        = camera.zFar;
+
+    buffer.update(&block, sizeof(Block))
+          .bindBase(GLuint(gl::Block::Frame))
+          .unbind();
+    return *this;
+}
+
+} // namespace gfx
+} // namespace pt
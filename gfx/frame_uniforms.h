@@ -0,0 +1,25 @@
+#pragma once
+
+#include "geom/aabb.h"
+#include "gl/buffers.h"
+#include "scene/camera.h"
+
+namespace pt
+{
+namespace gfx
+{
+
+// Camera and scene constants of the Frame block, uploaded once per frame
+// and bound for all programs declaring the block
+struct FrameUniforms
+{
+    gl::Buffer buffer;
+
+    FrameUniforms();
+
+    FrameUniforms& operator()(const Camera& camera, const Aabb& bounds,
+                              float time);
+};
+
+} // namespace gfx
+} // namespace pt
@@ -2,13 +2,14 @@
 
 #include "common/common.h"
 #include "common/log.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
 
-Geometry::Geometry(const Size<int>& renderSize) :
+Geometry::Geometry(const Size<int>& renderSize, FrameGraph& graph) :
     renderSize(renderSize),
     rect(squareMesh()),
     vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
@@ -20,10 +21,12 @@ Geometry::Geometry(const Size<int>& renderSize) :
     fsOitComposite(gl::Shader::path("oit_composite.fs.glsl")),
     fsDenoise(gl::Shader::path("denoise.fs.glsl")),
     fsLinearDepth(gl::Shader::path("linear_depth.fs.glsl")),
+    vsCommon(gl::Shader::path("common.vs.glsl")),
     fsCommon(gl::Shader::path("common.fs.glsl")),
-    progGeometry({vsGeometry, /*gsWireframe,*/ fsGeometry, fsCommon},
+    progGeometry({vsGeometry, vsCommon, /*gsWireframe,*/ fsGeometry, fsCommon},
                 {{0, "position"}, {1, "normal"}, {2, "tangent"}, {3, "uv"}}),
-    progGeometryTransparent({vsGeometryTransparent, fsGeometryTransparent, fsCommon},
+    progGeometryTransparent({vsGeometryTransparent, vsCommon,
+                             fsGeometryTransparent, fsCommon},
                 {{0, "position"}, {1, "normal"}, {2, "tangent"}, {3, "uv"}}),
     progOitComposite({vsQuad, fsOitComposite},
                     {{0, "position"}, {1, "uv"}}),
@@ -39,17 +42,12 @@ Geometry::Geometry(const Size<int>& renderSize) :
                    .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
                    .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    texDepthLinear.bind().alloc(fboSize, GL_R32F, GL_RED, GL_FLOAT)
-                         .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                         .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    texNormal.bind().alloc(fboSize,        GL_RGB16F,  GL_RGB, GL_FLOAT);
-    texNormalDenoise.bind().alloc(fboSize, GL_RGB16F,  GL_RGB, GL_FLOAT)
-                           .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                           .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    texColor.bind().alloc(fboSize, GL_RGB8,  GL_RGB,  GL_UNSIGNED_BYTE);
-    texLight.bind().alloc(fboSize, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    texDepthLinear   = graph.texture("depth-linear");
+    texNormal        = graph.texture("normal");
+    texNormalDenoise = graph.texture("normal-denoise");
+    texColor         = graph.texture("color");
+    texLight         = graph.texture("light");
+    texProbe         = graph.texture("probe");
 
     fbo.bind()
        .attach(texDepth,         gl::Fbo::Attachment::Depth)
@@ -58,11 +56,12 @@ Geometry::Geometry(const Size<int>& renderSize) :
        .attach(texLight,         gl::Fbo::Attachment::Color, 2)
        .attach(texNormalDenoise, gl::Fbo::Attachment::Color, 3)
        .attach(texDepthLinear,   gl::Fbo::Attachment::Color, 4)
+       .attach(texProbe,         gl::Fbo::Attachment::Color, 5)
        .unbind();
 
     // OIT
-    texOit0.bind().alloc(fboSize, GL_RGBA16F, GL_RGBA, GL_FLOAT);
-    texOit1.bind().alloc(fboSize, GL_R16F,    GL_RED,  GL_FLOAT);
+    texOit0 = graph.texture("oit0");
+    texOit1 = graph.texture("oit1");
 
     fboOit.bind()
           .attach(texDepth, gl::Fbo::Attachment::Depth)
@@ -71,9 +70,7 @@ Geometry::Geometry(const Size<int>& renderSize) :
           .unbind();
 
     // Composite
-    texComp.bind().alloc(fboSize, GL_RGB16F, GL_RGB, GL_FLOAT)
-                  .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                  .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texComp = graph.texture("comp");
     fboComp.bind()
            .attach(texComp, gl::Fbo::Attachment::Color)
            .unbind();
@@ -83,8 +80,7 @@ Geometry& Geometry::operator()(
     gl::Texture* texAlbedo,
     gl::Texture* texNormalMap,
     gl::Texture* texLightmap,
-    const Instances& instances,
-    const Camera& camera)
+    const Instances& instances)
 {
     {
         // Front faces
@@ -93,24 +89,27 @@ Geometry& Geometry::operator()(
                     .setUniform("texAlbedo", 0)
                     .setUniform("texNormal", 1)
                     .setUniform("texLight",  2)
-                    .setUniform("v",         camera.matrixView())
-                    .setUniform("p",         camera.matrixProj())
                     .setUniform("size",      renderSize.as<glm::vec2>());
 
         const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0,
                                       GL_COLOR_ATTACHMENT1,
-                                      GL_COLOR_ATTACHMENT2};
-        glDrawBuffers(3, drawBuffers);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glEnable(GL_DEPTH_TEST);
+                                      GL_COLOR_ATTACHMENT2,
+                                      GL_COLOR_ATTACHMENT5};
+        glDrawBuffers(4, drawBuffers);
+        gl::State::disable(GL_POLYGON_OFFSET_FILL);
+        gl::State::enable(GL_DEPTH_TEST);
         glDepthFunc(GL_LESS);
-        glDisable(GL_BLEND);
+        gl::State::disable(GL_BLEND);
         glDepthMask(GL_TRUE);
 
         glViewport(0, 0, renderSize.w, renderSize.h);
         glClearColor(0.f, 0.f, 0.f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // No probe unless an instance sets one
+        const GLfloat noProbe[] = {0.f, 0.f, 0.f, 0.f};
+        glClearBufferfv(GL_COLOR, 3, noProbe);
+
         texAlbedo->bindAs(GL_TEXTURE0);
         texNormalMap->bindAs(GL_TEXTURE1);
         texLightmap->bindAs(GL_TEXTURE2);
@@ -118,22 +117,22 @@ Geometry& Geometry::operator()(
         // Render primitives
         for (const auto& instance : instances)
         {
-            progGeometry.setUniform("m", instance.second);
-            instance.first.render();
+            progGeometry.setUniform("m",     instance.m)
+                        .setUniform("probe", instance.probe);
+            instance.primitive.render();
         }
 
         // Denoise normals
         progDenoise.bind().setUniform("tex", 0);
         glDrawBuffer(GL_COLOR_ATTACHMENT3);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         texNormal.bindAs(GL_TEXTURE0);
         rect.render();
 
         // Linearize depth
-        progLinearDepth.bind().setUniform("tex",  0)
-                              .setUniform("clip", camera.infoClip());
+        progLinearDepth.bind().setUniform("tex", 0);
         glDrawBuffer(GL_COLOR_ATTACHMENT4);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         texDepth.bindAs(GL_TEXTURE0);
         rect.render();
     }
@@ -147,27 +146,20 @@ Geometry& Geometry::operator()(
     gl::Texture* texLightmap,
     gl::Texture* texGi,
     gl::Texture* texIncid,
-    const Aabb& bounds,
-    const Instances& instances,
-    const Camera& camera)
+    const Instances& instances)
 {
     // OIT accumulation pass
     {
         Binder<gl::Fbo> binder(fboOit);
         progGeometryTransparent.bind()
-                               .setUniform("texAlbedo",  0)
-                               .setUniform("texLight",   1)
-                               .setUniform("texGi",      2)
-                               .setUniform("texIncid",   3)
-                               .setUniform("boundsMin",  glm::floor(bounds.min))
-                               .setUniform("boundsSize", glm::ceil(bounds.size()))
-                               .setUniform("viewPos",    camera.position())
-                               .setUniform("v",          camera.matrixView())
-                               .setUniform("p",          camera.matrixProj());
-        glEnable(GL_DEPTH_TEST);
+                               .setUniform("texAlbedo", 0)
+                               .setUniform("texLight",  1)
+                               .setUniform("texGi",     2)
+                               .setUniform("texIncid",  3);
+        gl::State::enable(GL_DEPTH_TEST);
         glDepthFunc(GL_LESS);
         glDepthMask(GL_FALSE);
-        glEnable(GL_BLEND);
+        gl::State::enable(GL_BLEND);
 
         texAlbedo->bindAs(GL_TEXTURE0);
         texLightmap->bindAs(GL_TEXTURE1);
@@ -190,10 +182,10 @@ Geometry& Geometry::operator()(
         // Render primitives
         for (const auto& instance : instances)
         {
-            progGeometryTransparent.setUniform("m", instance.second);
-            instance.first.render();
+            progGeometryTransparent.setUniform("m", instance.m);
+            instance.primitive.render();
         }
-        glDisable(GL_BLEND);
+        gl::State::disable(GL_BLEND);
     }
     // OIT composition pass
     {
@@ -206,7 +198,7 @@ Geometry& Geometry::operator()(
 
         glViewport(0, 0, renderSize.w, renderSize.h);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         glDepthMask(GL_FALSE);
         texOpaque->bindAs(GL_TEXTURE0);
         texEnv->bindAs(GL_TEXTURE1);
@@ -15,6 +15,8 @@
 
 #include "scene/camera.h"
 
+#include "frame_graph.h"
+
 namespace pt
 {
 namespace gfx
@@ -36,6 +38,7 @@ struct Geometry
                       fsOitComposite,
                       fsDenoise,
                       fsLinearDepth,
+                      vsCommon,
                       fsCommon;
 
     gl::ShaderProgram progGeometry,
@@ -50,6 +53,7 @@ struct Geometry
                       texNormalDenoise,
                       texColor,
                       texLight,
+                      texProbe,
                       texOit0,
                       texOit1,
                       texComp;
@@ -58,17 +62,28 @@ struct Geometry
                       fboOit,
                       fboComp;
 
-    using Instance  = std::pair<gl::Primitive, glm::mat4>;
+    // Primitive and model matrix. Instances with a light probe, w = 1, are
+    // lit at the probe world position instead of at each pixel.
+    struct Instance
+    {
+        Instance(const gl::Primitive& primitive, const glm::mat4& m,
+                 const glm::vec4& probe = glm::vec4(0.f)) :
+            primitive(primitive), m(m), probe(probe)
+        {}
+
+        gl::Primitive primitive;
+        glm::mat4     m;
+        glm::vec4     probe;
+    };
     using Instances = std::vector<Instance>;
 
-    Geometry(const Size<int>& renderSize);
+    Geometry(const Size<int>& renderSize, FrameGraph& graph);
 
     // Opaque
     Geometry& operator()(gl::Texture* texAlbedo,
                          gl::Texture* texNormalMap,
                          gl::Texture* texLightmap,
-                         const Instances& instances,
-                         const Camera& camera);
+                         const Instances& instances);
 
     // Transparent
     Geometry& operator()(gl::Texture* texOpaque,
@@ -77,9 +92,7 @@ struct Geometry
                          gl::Texture* texLightmap,
                          gl::Texture* texGi,
                          gl::Texture* texIncid,
-                         const Aabb& bounds,
-                         const Instances& instances,
-                         const Camera& camera);
+                         const Instances& instances);
 };
 
 } // namespace gfx
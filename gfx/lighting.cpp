@@ -4,6 +4,7 @@
 
 #include "common/common.h"
 #include "common/log.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -19,7 +20,8 @@ struct Lighting::Data
     gl::Texture* texScOut = nullptr;
 };
 
-Lighting::Lighting(const cfg::Video& config, const gl::Texture& texDepth) :
+Lighting::Lighting(const cfg::Video& config, const gl::Texture& texDepth,
+                   FrameGraph& graph) :
     rect(squareMesh()),
     vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
     fsSc(gl::Shader::path("lighting_scattering.fs.glsl")),
@@ -29,22 +31,18 @@ Lighting::Lighting(const cfg::Video& config, const gl::Texture& texDepth) :
            {{0, "position"}, {1, "uv"}}),
     progOut({vsQuad, fsOut, fsCommon},
             {{0, "position"}, {1, "uv"}}),
-    blurSc(Size<int>(config.sc.scale * config.output.renderSize())),
     scSampleCount(config.sc.samples),
     d(std::make_shared<Data>())
 {
     // Texture and FBO
-    auto size    = config.output.renderSize();
-    auto sizeSc  = {int(config.sc.scale * size.x), int(config.sc.scale * size.y)};
-    auto sizeOut = {int(size.x), int(size.y)};
+    texSc  = graph.texture("sc");
+    texOut = graph.texture("lit");
 
-    texSc.bind().alloc(sizeSc, GL_RGB16F, GL_RGB, GL_FLOAT)
-                .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    texOut.bind().alloc(sizeOut, GL_RGB16F, GL_RGB, GL_FLOAT)
-                 .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                 .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Downscaled scattering is blurred
+    const Size<int> sizeSc(texSc.size().xy());
+    if (sizeSc.w < texOut.size().x)
+        blurSc = Blur(sizeSc, graph.texture("sc-blur0"),
+                              graph.texture("sc-blur1"));
 
     fboSc.bind()
          .attach(texSc, gl::Fbo::Attachment::Color)
@@ -56,24 +54,18 @@ Lighting::Lighting(const cfg::Video& config, const gl::Texture& texDepth) :
 }
 
 Lighting& Lighting::sc(gl::Texture* texDepth,
-                       gl::Texture* texLightmap,
-                       const Camera& camera,
-                       const Aabb& bounds)
+                       gl::Texture* texLightmap)
 {
     // Scattering pass
     Binder<gl::Fbo> binder(fboSc);
     progSc.bind().setUniform("texDepth",    0)
                  .setUniform("texGi",       1)
-                 .setUniform("w",           camera.matrixWorld())
-                 .setUniform("camPos",      camera.position())
-                 .setUniform("boundsMin",   glm::floor(bounds.min))
-                 .setUniform("boundsSize",  glm::ceil(bounds.size()))
                  .setUniform("sampleCount", scSampleCount);
 
     const auto size = texSc.size();
     glViewport(0, 0, size.x, size.y);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
     texDepth->bindAs(GL_TEXTURE0);
     texLightmap->bindAs(GL_TEXTURE1)
@@ -96,36 +88,28 @@ Lighting& Lighting::operator()(
     gl::Texture* texNormal,
     gl::Texture* texColor,
     gl::Texture* texLight,
+    gl::Texture* texProbe,
     gl::Texture* texSsao,
     gl::Texture* texLightmap,
-    gl::Texture* texIncidence,
-    const Camera& camera,
-    const Aabb& bounds,
-    float time)
+    gl::Texture* texIncidence)
 {
     // Combine pass
     Binder<gl::Fbo> binder(fboOut);
-    progOut.bind().setUniform("texDepth",    0)
-                  .setUniform("texNormal",   1)
-                  .setUniform("texColor",    2)
-                  .setUniform("texLight",    3)
-                  .setUniform("texAo",       4)
-                  .setUniform("texSc",       5)
-                  .setUniform("texGi",       6)
-                  .setUniform("texIncid",    7)
-                  .setUniform("z",           0.f)
-                  .setUniform("tanHalfFov",  camera.tanHalfFov())
-                  .setUniform("aspectRatio", camera.ar)
-                  .setUniform("w",           camera.matrixWorld())
-                  .setUniform("n",           camera.matrixNormal())
-                  .setUniform("boundsMin",   glm::floor(bounds.min))
-                  .setUniform("boundsSize",  glm::ceil(bounds.size()))
-                  .setUniform("time",        time);
+    progOut.bind().setUniform("texDepth",  0)
+                  .setUniform("texNormal", 1)
+                  .setUniform("texColor",  2)
+                  .setUniform("texLight",  3)
+                  .setUniform("texAo",     4)
+                  .setUniform("texSc",     5)
+                  .setUniform("texGi",     6)
+                  .setUniform("texIncid",  7)
+                  .setUniform("texProbe",  8)
+                  .setUniform("z",         0.f);
 
     const auto size = texOut.size();
     glViewport(0, 0, size.x, size.y);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
     texDepth->bindAs(GL_TEXTURE0);
     texNormal->bindAs(GL_TEXTURE1);
@@ -138,6 +122,7 @@ Lighting& Lighting::operator()(
                 .set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE)
                 .set(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     texIncidence->bindAs(GL_TEXTURE7);
+    texProbe->bindAs(GL_TEXTURE8);
     rect.render();
     return *this;
 }
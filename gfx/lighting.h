@@ -15,6 +15,8 @@
 #include "scene/camera.h"
 #include "common/config.h"
 
+#include "frame_graph.h"
+
 #include "blur.h"
 
 namespace pt
@@ -44,24 +46,21 @@ struct Lighting
 
     int               scSampleCount;
 
-    Lighting(const cfg::Video& config, const gl::Texture& texDepth);
+    Lighting(const cfg::Video& config, const gl::Texture& texDepth,
+             FrameGraph& graph);
 
     Lighting& sc(gl::Texture* texDepth,
-                 gl::Texture* texLightmap,
-                 const Camera& camera,
-                 const Aabb& bounds);
+                 gl::Texture* texLightmap);
 
     Lighting& operator()(
         gl::Texture* texDepth,
         gl::Texture* texNormal,
         gl::Texture* texColor,
         gl::Texture* texLight,
+        gl::Texture* texProbe,
         gl::Texture* texSsao,
         gl::Texture* texLightmap,
-        gl::Texture* texIncidence,
-        const Camera& camera,
-        const Aabb& bounds,
-        float time);
+        gl::Texture* texIncidence);
 
     gl::Texture* output();
 
@@ -1,14 +1,30 @@
 #include "lightmapper.h"
 
+#include <cmath>
+
 #include "gl/fbo.h"
 #include "gl/shaders.h"
 #include "gl/primitive.h"
 #include "gl/gpu_clock.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
+namespace
+{
+
+// Light attenuation, 1 / (K0 + K1 * d + K2 * d^2), cut off below ATT_MIN
+constexpr float ATT_MIN = 0.001f;
+constexpr float K0      = 1.f;
+constexpr float K1      = 0.22f;
+constexpr float K2      = 0.2f;
+
+// Upscaling filter reach, in cells
+constexpr int UPSCALE_MARGIN = 2;
+
+} // namespace
 
 struct Lightmap::Data
 {
@@ -30,7 +46,10 @@ struct Lightmap::Data
         incidence {gl::Texture::Type::Texture3d, gl::Texture::Type::Texture3d},
         density   {gl::Texture::Type::Texture3d},
         emission  {gl::Texture::Type::Texture3d},
-        emitters  {gl::Texture::Type::Buffer}
+        occlusion {gl::Texture::Type::Texture3d},
+        emitters  {gl::Texture::Type::Buffer},
+        emitterCount(0),
+        horizonLit(false)
     {}
 
     operator bool() const
@@ -43,6 +62,116 @@ struct Lightmap::Data
         return light.first.size();
     }
 
+    // Bakes the cells in [min, max) and upscales the high quality texels
+    // they reach
+    void bake(const glm::ivec3& min, const glm::ivec3& max)
+    {
+        if (glm::any(glm::greaterThanEqual(min, max)))
+            return;
+
+        gl::State::enable(GL_SCISSOR_TEST);
+        {
+            const Time<GpuClock> clock;
+            const auto size = light.first.size();
+
+            // Bake pass
+            gl::Fbo fbo;
+            Binder<gl::Fbo> fboBinder(&fbo);
+            Binder<gl::ShaderProgram> progBinder(&prog);
+            prog.setUniform("density",   0)
+                .setUniform("emission",  1)
+                .setUniform("horizon",   2)
+                .setUniform("lightSrc",  3)
+                .setUniform("occlusion", 4)
+                .setUniform("lsc",       emitterCount)
+                .setUniform("attMin",    ATT_MIN)
+                .setUniform("k0",        K0)
+                .setUniform("k1",        K1)
+                .setUniform("k2",        K2)
+                .setUniform("cs",        c::cell::SIZE.xzy());
+
+            const GLenum buffers[] = {GL_COLOR_ATTACHMENT0,
+                                      GL_COLOR_ATTACHMENT1};
+
+            glViewport(0, 0, size.x, size.y);
+            glScissor(min.x, min.y, max.x - min.x, max.y - min.y);
+            glDrawBuffers(2, buffers);
+            gl::State::disable(GL_DEPTH_TEST);
+            glDepthMask(GL_FALSE);
+
+            density.bindAs(GL_TEXTURE0);
+            emission.bindAs(GL_TEXTURE1);
+            horizon.texture().bindAs(GL_TEXTURE2);
+            emitters.bindAs(GL_TEXTURE3);
+            occlusion.bindAs(GL_TEXTURE4);
+
+            // Z-layers
+            for (int z = min.z; z < max.z; ++z)
+            {
+                constexpr auto attachment = gl::Fbo::Attachment::Color;
+                fbo.attach(light.first,     attachment, 0, 0, z);
+                fbo.attach(incidence.first, attachment, 1, 0, z);
+                prog.setUniform("wz", z);
+                rect.render();
+            }
+
+            #if 0
+            const auto elapsed = std::chrono::duration<float, boost::milli>
+                                (clock.elapsed()).count();
+            const auto vol     = size.x * size.y * size.z;
+            PTLOG(Info) << "elapsed " << elapsed << " ms, "
+                        << (vol / elapsed) << " cells/ms";
+            #endif
+        }
+        {
+            // Upscale HQ textures
+            const Time<GpuClock> clockHq;
+            const auto size  = light.second.size();
+            const auto scale = size / light.first.size();
+            const auto minHq = glm::max(scale * (min - UPSCALE_MARGIN),
+                                        glm::ivec3(0));
+            const auto maxHq = glm::min(scale * (max + UPSCALE_MARGIN), size);
+
+            gl::Fbo fbo;
+            Binder<gl::Fbo> fboBinder(&fbo);
+            Binder<gl::ShaderProgram> progBinder(&progHq);
+            progHq.setUniform("texGi",  0)
+                  .setUniform("texInc", 1);
+
+            const GLenum buffers[] = {GL_COLOR_ATTACHMENT0,
+                                      GL_COLOR_ATTACHMENT1};
+
+            glViewport(0, 0, size.x, size.y);
+            glScissor(minHq.x, minHq.y, maxHq.x - minHq.x, maxHq.y - minHq.y);
+            glDrawBuffers(2, buffers);
+            gl::State::disable(GL_DEPTH_TEST);
+            glDepthMask(GL_FALSE);
+
+            light.first.bindAs(GL_TEXTURE0);
+            incidence.first.bindAs(GL_TEXTURE1);
+
+            // Z-layers
+            for (int z = minHq.z; z < maxHq.z; ++z)
+            {
+                constexpr auto attachment = gl::Fbo::Attachment::Color;
+                fbo.attach(light.second,     attachment, 0, 0, z);
+                fbo.attach(incidence.second, attachment, 1, 0, z);
+                progHq.setUniform("z", float(z) / (size.z - 1));
+                rect.render();
+            }
+
+            #if 0
+            const auto elapsed = std::chrono::duration<float, boost::milli>
+                                (clockHq.elapsed()).count();
+            const auto vol     = size.x * size.y * size.z;
+            PTLOG(Info) << "HQ elapsed " << elapsed << " ms, "
+                        << "size: " << size.x << "x" << size.y << "x" << size.z
+                        << ", " << (vol / elapsed) << " cells/ms";
+            #endif
+        }
+        gl::State::disable(GL_SCISSOR_TEST);
+    }
+
     // Primitive
     gl::Primitive     rect;
 
@@ -62,8 +191,13 @@ struct Lightmap::Data
     // Current lightmap textures, normal/high quality
     mutable Tex       light, incidence;
 
-    // Work buffers for lightmap computation
-    gl::Texture       density, emission, emitters;
+    // Work buffers for lightmap computation, occlusion of dynamic items
+    // apart from the static density
+    gl::Texture       density, emission, occlusion, emitters;
+    gl::Buffer        emittersBuf;
+    int               emitterCount;
+    Horizon           horizon;
+    bool              horizonLit;
 
     // Debug texture
     gl::Texture       debug;
@@ -117,14 +251,19 @@ Lightmap& Lightmap::resize(const Size& size)
 
 Lightmap& Lightmap::update(const mat::Density& density,
                            const mat::Emission& emission,
+                           const mat::Occlusion& occlusion,
                            const Emitters& emitters,
                            const Horizon& horizon)
 {
     if (*d)
     {
         // Create emitter buffer
-        gl::Buffer emittersBuf(gl::Buffer::Type::Texture);
-        emittersBuf.alloc(emitters.data(), sizeof(Emitter) * emitters.size());
+        d->emittersBuf = gl::Buffer(gl::Buffer::Type::Texture);
+        d->emittersBuf.alloc(emitters.data(),
+                             sizeof(Emitter) * emitters.size());
+        d->emitterCount = int(emitters.size());
+        d->horizon      = horizon;
+        d->horizonLit   = horizon.image().maxToAlpha().channelPopulated(3);
 
         // Upload buffers
         constexpr auto wrap = GL_CLAMP_TO_BORDER;
@@ -136,106 +275,45 @@ Lightmap& Lightmap::update(const mat::Density& density,
                           .set(GL_TEXTURE_WRAP_S, wrap)
                           .set(GL_TEXTURE_WRAP_T, wrap)
                           .set(GL_TEXTURE_WRAP_R, wrap);
-        d->emitters.bind().alloc(GL_RGBA16I, emittersBuf);
-        {
-            const Time<GpuClock> clock;
-            const auto size = d->light.first.size();
-
-            // Bake pass
-            gl::Fbo fbo;
-            Binder<gl::Fbo> fboBinder(&fbo);
-            Binder<gl::ShaderProgram> progBinder(&d->prog);
-            d->prog.setUniform("density",  0)
-                   .setUniform("emission", 1)
-                   .setUniform("horizon",  2)
-                   .setUniform("lightSrc", 3)
-                   .setUniform("lsc",      int(emitters.size()))
-                   .setUniform("attMin",   0.001f)
-                   .setUniform("k0",       1.f)
-                   .setUniform("k1",       0.22f)
-                   .setUniform("k2",       0.2f)
-                   .setUniform("cs",       c::cell::SIZE.xzy());
-
-            const GLenum buffers[] = {GL_COLOR_ATTACHMENT0,
-                                      GL_COLOR_ATTACHMENT1};
-
-            glViewport(0, 0, size.x, size.y);
-            glDrawBuffers(2, buffers);
-            glDisable(GL_DEPTH_TEST);
-            glDepthMask(GL_FALSE);
-
-            d->density.bindAs(GL_TEXTURE0);
-            d->emission.bindAs(GL_TEXTURE1);
-            horizon.texture().bindAs(GL_TEXTURE2);
-            d->emitters.bindAs(GL_TEXTURE3);
+        d->emitters.bind().alloc(GL_RGBA16I, d->emittersBuf);
+        d->occlusion.bind().alloc(occlusion);
 
-            // Z-layers
-            for (int z = 0; z < size.z; ++z)
-            {
-                constexpr auto attachment = gl::Fbo::Attachment::Color;
-                fbo.attach(d->light.first,     attachment, 0, 0, z);
-                fbo.attach(d->incidence.first, attachment, 1, 0, z);
-                d->prog.setUniform("wz", z);
-                d->rect.render();
-            }
+        d->bake(glm::ivec3(0), d->size());
+    }
+    return *this;
+}
 
-            #if 0
-            const auto elapsed = std::chrono::duration<float, boost::milli>
-                                (clock.elapsed()).count();
-            const auto vol     = size.x * size.y * size.z;
-            PTLOG(Info) << "elapsed " << elapsed << " ms, "
-                        << (vol / elapsed) << " cells/ms";
-            #endif
-        }
+Lightmap& Lightmap::update(const mat::Occlusion& occlusion,
+                           const glm::ivec3& min, const glm::ivec3& max)
+{
+    if (*d && d->emitters)
+    {
+        // Point lights reach the cells within range, horizon light is
+        // traced from the volume edge across the whole z-layer
+        const auto size = d->size();
+        auto bakeMin    = min - range();
+        auto bakeMax    = max + range();
+        if (d->horizonLit)
         {
-            // Upscale HQ textures
-            const Time<GpuClock> clockHq;
-            const auto size = d->light.second.size();
-
-            gl::Fbo fbo;
-            Binder<gl::Fbo> fboBinder(&fbo);
-            Binder<gl::ShaderProgram> progBinder(&d->progHq);
-            d->progHq.setUniform("texGi",  0)
-                     .setUniform("texInc", 1);
-
-            const GLenum buffers[] = {GL_COLOR_ATTACHMENT0,
-                                      GL_COLOR_ATTACHMENT1};
-
-            glViewport(0, 0, size.x, size.y);
-            glDrawBuffers(2, buffers);
-            glDisable(GL_DEPTH_TEST);
-            glDepthMask(GL_FALSE);
-
-            d->light.first.bindAs(GL_TEXTURE0);
-            d->incidence.first.bindAs(GL_TEXTURE1);
-
-            // Z-layers
-            for (int z = 0; z < size.z; ++z)
-            {
-                constexpr auto attachment = gl::Fbo::Attachment::Color;
-                fbo.attach(d->light.second,     attachment, 0, 0, z);
-                fbo.attach(d->incidence.second, attachment, 1, 0, z);
-                d->progHq.setUniform("z", float(z) / (size.z - 1));
-                d->rect.render();
-            }
-
-            #if 0
-            const auto elapsed = std::chrono::duration<float, boost::milli>
-                                (clockHq.elapsed()).count();
-            const auto vol     = size.x * size.y * size.z;
-            PTLOG(Info) << "HQ elapsed " << elapsed << " ms, "
-                        << "size: " << size.x << "x" << size.y << "x" << size.z
-                        << ", " << (vol / elapsed) << " cells/ms";
-            #endif
+            bakeMin.x = bakeMin.y = 0;
+            bakeMax.x = size.x;
+            bakeMax.y = size.y;
         }
+
+        d->occlusion.bind().alloc(occlusion);
+        d->bake(glm::max(bakeMin, glm::ivec3(0)), glm::min(bakeMax, size));
     }
     return *this;
 }
 
+glm::ivec3 Lightmap::range()
+{
+    const auto radius = std::sqrt(1.f / (K2 * ATT_MIN));
+    return glm::ivec3(glm::ceil(radius / c::cell::SIZE.xzy()));
+}
+
 gl::Texture& Lightmap::debug(gl::Texture* texDepth,
-                             const pt::Size<int>& size,
-                             const Camera& camera,
-                             const Aabb& bounds)
+                             const pt::Size<int>& size)
 {
     if (!d->debug)
         d->debug.bind().alloc({size.w, size.h},
@@ -248,15 +326,11 @@ gl::Texture& Lightmap::debug(gl::Texture* texDepth,
     Binder<gl::ShaderProgram> progBinder(&d->progDebug);
     d->progDebug.setUniform("texDepth",    0)
                 .setUniform("texDensity",  1)
-                .setUniform("w",           camera.matrixWorld())
-                .setUniform("camPos",      camera.position())
-                .setUniform("boundsMin",   glm::floor(bounds.min))
-                .setUniform("boundsSize",  glm::ceil(bounds.size()))
                 .setUniform("sampleCount", int(1000));
 
     glViewport(0, 0, size.w, size.h);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glDisable(GL_DEPTH_TEST);
+    gl::State::disable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
     texDepth->bindAs(GL_TEXTURE0);
     d->density.bindAs(GL_TEXTURE1);
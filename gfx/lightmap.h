@@ -38,15 +38,24 @@ struct Lightmap
     Size size() const;
     Lightmap& resize(const Size& size);
 
+    // Full bake of the static density and emission, and the occlusion of
+    // dynamic items
     Lightmap& update(const mat::Density& density,
                      const mat::Emission& emission,
+                     const mat::Occlusion& occlusion,
                      const Emitters& emitters,
                      const Horizon& horizon);
 
+    // Bake after a dynamic occlusion change of the cells in [min, max),
+    // over the cells whose light may pass through them
+    Lightmap& update(const mat::Occlusion& occlusion,
+                     const glm::ivec3& min, const glm::ivec3& max);
+
+    // Cells a light reaches along each axis
+    static glm::ivec3 range();
+
     gl::Texture& debug(gl::Texture* texDepth,
-                       const pt::Size<int>& size,
-                       const Camera& camera,
-                       const Aabb& bounds);
+                       const pt::Size<int>& size);
 
 private:
     struct Data;
@@ -27,19 +27,18 @@ struct ivec4_cmp : std::binary_function<glm::ivec4, glm::ivec4, bool>
 };
 using Emitters = std::set<glm::ivec4, ivec4_cmp>;
 
-void accumulate(
-    mat::Density& density0,
-    mat::Emission& emission0,
-    Emitters& emitters,
-    const glm::vec3& pos,
-    const glm::mat4& rot,
-    const Object& obj)
+// Visits the cells p0 of a grid of size0 covered by an object placed at
+// pos, rot, with the matching cells p1 of the object density
+template <typename F>
+void forEachCell(const glm::ivec3& size0,
+                 const glm::vec3& pos,
+                 const glm::mat4& rot,
+                 const Object& obj,
+                 F f)
 {
     const auto  posCell   = pos / c::cell::SIZE;
     const auto  origin    = obj.origin().xzy() / c::cell::SIZE;
     const auto& density1  = obj.density();
-    const auto& emission1 = obj.emission();
-    const auto& pulse1    = obj.pulse();
 
     const auto rotInv     = glm::inverse(rot);
     const auto aabb       = density1.bounds(posCell, origin)
@@ -47,7 +46,7 @@ void accumulate(
     const auto size1      = density1.size;
     const auto min0       = glm::max(glm::zero<glm::ivec3>(),
                                      glm::ivec3(glm::round(aabb.min)));
-    const auto max0       = glm::min(density0.size,
+    const auto max0       = glm::min(size0,
                                      glm::ivec3(glm::round(aabb.max)));
     const auto origin0    = posCell - 0.5f;
     const auto origin1    = 0.5f * glm::vec3(size1.x, size1.y, 0.f) + origin - 0.5f;
@@ -56,8 +55,6 @@ void accumulate(
                             rot *
                             glm::translate(-origin0);
 
-    const auto pulse      = int(std::round(pulse1.x * 255)) |
-                           (int(std::round(pulse1.y * 255)) << 8);
     #if 0
     PTLOG(Info) << "pos: " << glm::to_string(pos)
                 << ", aabb: " << glm::to_string(aabb.min)
@@ -85,29 +82,52 @@ void accumulate(
                                 << ", " << glm::to_string(origin1 + xv);
                     #endif
 
-                    auto& d0        = density0.at(p0);
-                    const auto& d1  = density1.at(p1);
+                    f(glm::ivec3(p0), p1);
+                }
+            }
+}
+
+// Opacity is left out for objects occluding dynamically, which keep
+// their emission and tint here
+void accumulate(
+    mat::Density& density0,
+    mat::Emission& emission0,
+    Emitters& emitters,
+    const glm::vec3& pos,
+    const glm::mat4& rot,
+    const Object& obj,
+    bool opaque = true)
+{
+    const auto& density1  = obj.density();
+    const auto& emission1 = obj.emission();
+    const auto& pulse1    = obj.pulse();
+    const auto pulse      = int(std::round(pulse1.x * 255)) |
+                           (int(std::round(pulse1.y * 255)) << 8);
+
+    forEachCell(density0.size, pos, rot, obj,
+                [&](const glm::ivec3& p0, const glm::ivec3& p1)
+    {
+        auto& d0        = density0.at(p0);
+        const auto& d1  = density1.at(p1);
 
-                    const auto aMin = std::min(d0.a, d1.a);
-                    const auto a    = aMin < 0.f ? aMin :
-                                      std::min(1.f, d0.a + d1.a);
-                    const auto rgb  = d0.rgb() + d1.rgb();
+        if (opaque || d1.a < 0.f)
+        {
+            const auto aMin = std::min(d0.a, d1.a);
+            const auto a    = aMin < 0.f ? aMin :
+                              std::min(1.f, d0.a + d1.a);
+            const auto rgb  = d0.rgb() + d1.rgb();
 
-                    d0 = glm::vec4(rgb, a);
+            d0 = glm::vec4(rgb, a);
+        }
 
-                    const auto em1 = emission1.at(p1);
-                    if (em1 != glm::zero<glm::vec3>())
-                    {
-                        auto em0 = emission0.at(p0);
-                        emission0.at(p0) = em0 + em1;
-                        emitters.insert({p0, pulse});
-                    }
-                }
-                #if 0
-                else
-                    density0.at(p0) = glm::vec4(1.f, 1.f, 0.f, 1.f);
-                #endif
-            }
+        const auto em1 = emission1.at(p1);
+        if (em1 != glm::zero<glm::vec3>())
+        {
+            auto em0 = emission0.at(p0);
+            emission0.at(p0) = em0 + em1;
+            emitters.insert({p0, pulse});
+        }
+    });
 
     #if 0
     for (int z = 0; z < density1.size.z; ++z)
@@ -120,16 +140,36 @@ void accumulate(
     #endif
 }
 
+// Opacity only, emissive cells do not occlude
+void occlude(
+    mat::Occlusion& occlusion0,
+    const glm::vec3& pos,
+    const glm::mat4& rot,
+    const Object& obj)
+{
+    const auto& density1 = obj.density();
+    forEachCell(occlusion0.size, pos, rot, obj,
+                [&](const glm::ivec3& p0, const glm::ivec3& p1)
+    {
+        auto& o0 = occlusion0.at(p0);
+        o0       = std::min(1.f, o0 + std::max(0.f, density1.at(p1).a));
+    });
+}
+
 } // namespace
 
 struct Lightmapper::Data
 {
     Data() = default;
 
-    mat::Density  density;
-    mat::Emission emission;
-    Emitters      emitters;
-    Lightmap      lightmap;
+    mat::Density   density;
+    mat::Emission  emission;
+    Emitters       emitters;
+    Lightmap       lightmap;
+
+    // Occlusion of dynamic items, current and as last baked
+    mat::Occlusion occlusion,
+                   occlusionBaked;
 };
 
 Lightmapper::Lightmapper() :
@@ -157,6 +197,8 @@ Lightmapper& Lightmapper::reset(const glm::ivec3& size)
     d->density  = mat::Density(size);
     d->emission = mat::Emission(size);
     d->emitters.clear();
+    d->occlusion      = mat::Occlusion(size);
+    d->occlusionBaked = mat::Occlusion(size);
     return *this;
 }
 
@@ -176,6 +218,53 @@ Lightmapper& Lightmapper::add(const Transform& xform,
     return add(pos, rot, obj);
 }
 
+Lightmapper& Lightmapper::addMovable(const Transform& xform,
+                                     const Object& obj)
+{
+    const auto pos = xform.pos.xzy();
+    const auto rot = Transform::rotation(c::grid::UP, xform.rot);
+    accumulate(d->density, d->emission, d->emitters, pos, rot, obj, false);
+    return *this;
+}
+
+Lightmapper& Lightmapper::resetOccluders()
+{
+    d->occlusion = 0.f;
+    return *this;
+}
+
+Lightmapper& Lightmapper::addOccluder(const Transform& xform,
+                                      const Object& obj)
+{
+    const auto pos = xform.pos.xzy();
+    const auto rot = Transform::rotation(c::grid::UP, xform.rot);
+    occlude(d->occlusion, pos, rot, obj);
+    return *this;
+}
+
+Lightmapper& Lightmapper::updateOccluders()
+{
+    // Bounds of the changed cells
+    const auto size = d->occlusion.size;
+    glm::ivec3 min(size), max(0), p;
+    for (p.z = 0; p.z < size.z; ++p.z)
+        for (p.y = 0; p.y < size.y; ++p.y)
+            for (p.x = 0; p.x < size.x; ++p.x)
+                if (d->occlusion.at(p) != d->occlusionBaked.at(p))
+                {
+                    min = glm::min(min, p);
+                    max = glm::max(max, p + 1);
+                }
+
+    // Re-bake the cells whose light passes there
+    if (glm::all(glm::lessThan(min, max)))
+    {
+        d->lightmap.update(d->occlusion, min, max);
+        d->occlusionBaked = d->occlusion;
+    }
+    return *this;
+}
+
 Lightmapper& Lightmapper::operator()(const Horizon& horizon)
 {
     Lightmap::Emitters emitters;
@@ -184,7 +273,9 @@ Lightmapper& Lightmapper::operator()(const Horizon& horizon)
         emitters.push_back({int16_t(e.x), int16_t(e.y),
                             int16_t(e.z), int16_t(e.w)});
 
-    d->lightmap.update(d->density, d->emission, emitters, horizon);
+    d->lightmap.update(d->density, d->emission, d->occlusion,
+                       emitters, horizon);
+    d->occlusionBaked = d->occlusion;
     return *this;
 }
 
@@ -37,6 +37,17 @@ struct Lightmapper
     Lightmapper& add(const Transform& xform,
                      const Object& obj);
 
+    // Emission and tint of an object whose opacity is added as an occluder
+    Lightmapper& addMovable(const Transform& xform, const Object& obj);
+
+    // Dynamic occluders, accumulated anew each step apart from the static
+    // density
+    Lightmapper& resetOccluders();
+    Lightmapper& addOccluder(const Transform& xform, const Object& obj);
+
+    // Re-bakes the cells whose light passes changed occlusion
+    Lightmapper& updateOccluders();
+
     Lightmapper& operator()(const Horizon& horizon);
 
 private:
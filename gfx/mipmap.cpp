@@ -6,6 +6,7 @@
 #include "gl/primitive.h"
 #include "gl/shaders.h"
 #include "gl/fbo.h"
+#include "gl/state.h"
 
 #include "blur.h"
 
@@ -78,7 +79,7 @@ Mipmap& Mipmap::operator()(gl::Texture* tex, gl::Texture* texDepth)
         d->prog.bind().setUniform("tex", 0);
         glViewport(0, 0, d->size.w, d->size.h);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         glDepthMask(GL_FALSE);
         tex->bindAs(GL_TEXTURE0);
         d->rect.render();
@@ -92,7 +93,7 @@ Mipmap& Mipmap::operator()(gl::Texture* tex, gl::Texture* texDepth)
         d->prog.bind().setUniform("tex", 0);
         glViewport(0, 0, size.w, size.h);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         glDepthMask(GL_FALSE);
         gl::Texture& scaleSrc = i > 1 ? d->texScales[i - 1] : d->tex;
         scaleSrc.bindAs(GL_TEXTURE0);
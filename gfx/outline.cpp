@@ -1,6 +1,7 @@
 #include "outline.h"
 
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -46,11 +47,11 @@ Outline& Outline::operator()(gl::Fbo* fboOut,
     {
         Binder<gl::Fbo> binder(fboModel);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glEnable(GL_DEPTH_TEST);
+        gl::State::enable(GL_DEPTH_TEST);
         glDepthFunc(GL_LEQUAL);
         glDepthMask(GL_FALSE);
 
-        glEnable(GL_POLYGON_OFFSET_FILL);
+        gl::State::enable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(0, -1000.f);
 
         glClear(GL_COLOR_BUFFER_BIT);
@@ -63,23 +64,24 @@ Outline& Outline::operator()(gl::Fbo* fboOut,
             {
                 const auto mvp = camera.matrix() *
                                  xform.matrix(obj.dimensions(), obj.origin());
-                progModel.setUniform("mvp", mvp);
-                model.primitive().render();
+                const auto prim = model.primitive();
+                progModel.setUniform("mvp", mvp * prim.unpack);
+                prim.render();
             }
     }
     {
         Binder<gl::Fbo> binder(fboDenoise);
         progDenoise.bind().setUniform("tex", 0);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         texModel.bindAs(GL_TEXTURE0);
         rect.render();
     }
     {
         Binder<gl::Fbo> binder(fboOut);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_POLYGON_OFFSET_FILL);
+        gl::State::disable(GL_DEPTH_TEST);
         glDepthMask(false);
 
         texColor->bindAs(GL_TEXTURE0);
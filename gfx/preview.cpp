@@ -1,6 +1,7 @@
 #include "preview.h"
 
 #include "common/common.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -12,9 +13,10 @@ Preview::Preview(const Size<int>& renderSize) :
     rect(squareMesh()),
     vsQuad(gl::Shader::path("quad_uv.vs.glsl")),
     vsModel(gl::Shader::path("model.vs.glsl")),
+    vsCommon(gl::Shader::path("common.vs.glsl")),
     fsModel(gl::Shader::path("model.fs.glsl")),
     fsDenoise(gl::Shader::path("denoise.fs.glsl")),
-    progModel({vsModel, fsModel},
+    progModel({vsModel, vsCommon, fsModel},
              {{0, "position"}, {1, "normal"}, {2, "tangent"}, {3, "uv"}}),
     progDenoise({vsQuad, fsDenoise},
                {{0, "position"}, {1, "uv"}}),
@@ -48,10 +50,10 @@ Preview& Preview::operator()(
         progModel.bind().setUniform("texAlbedo", 0);
 
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glEnable(GL_DEPTH_TEST);
+        gl::State::disable(GL_POLYGON_OFFSET_FILL);
+        gl::State::enable(GL_DEPTH_TEST);
         glDepthFunc(GL_LESS);
-        glDisable(GL_BLEND);
+        gl::State::disable(GL_BLEND);
         glDepthMask(GL_TRUE);
 
         glViewport(0, 0, renderSize.w, renderSize.h);
@@ -72,8 +74,9 @@ Preview& Preview::operator()(
                                  Transform({-t.x, 0.f, -t.z}).
                                  matrix(obj.dimensions(), obj.origin());
 
-                progModel.setUniform("mvp", mvp);
-                model.primitive().render();
+                const auto prim = model.primitive();
+                progModel.setUniform("mvp", mvp * prim.unpack);
+                prim.render();
             }
     }
     {
@@ -81,7 +84,7 @@ Preview& Preview::operator()(
         progDenoise.bind().setUniform("tex", 0)
                           .setUniform("e",   0.1f);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         texColor.bindAs(GL_TEXTURE0);
         rect.render();
     }
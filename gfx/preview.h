@@ -26,6 +26,7 @@ struct Preview
 
     gl::Shader        vsQuad,
                       vsModel,
+                      vsCommon,
                       fsModel,
                       fsDenoise;
 
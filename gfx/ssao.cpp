@@ -8,6 +8,7 @@
 
 #include "common/common.h"
 #include "common/log.h"
+#include "gl/state.h"
 
 namespace pt
 {
@@ -50,7 +51,8 @@ std::vector<float> noiseData(int size)
 
 Ssao::Ssao(int kernelSize,
            const Size<int>& displaySize,
-           const Size<int>& renderSize) :
+           const Size<int>& renderSize,
+           FrameGraph& graph) :
     kernelSize(kernelSize),
     displaySize(displaySize),
     renderSize(renderSize),
@@ -62,12 +64,10 @@ Ssao::Ssao(int kernelSize,
     fsAo(gl::Shader::path("ssao.fs.glsl")),
     progAo({vsQuad, fsAo, fsCommon},
           {{0, "position"}, {1, "uv"}}),
-    blur(renderSize)
+    blur(renderSize, graph.texture("ao-blur0"), graph.texture("ao-blur1"))
 {
-    auto fboSize = {renderSize.w, renderSize.h};
-
     // Alloc textures
-    texAo.bind().alloc(fboSize, GL_R8, GL_RED, GL_UNSIGNED_BYTE);
+    texAo = graph.texture("ao");
 
     // Alloc and generate noise texture
     texNoise.bind().alloc({noiseSize.w, noiseSize.h},
@@ -89,25 +89,20 @@ glm::vec2 Ssao::noiseScale() const
 }
 
 Ssao& Ssao::operator()(gl::Texture* texDepth,
-                       gl::Texture* texNormal,
-                       const glm::mat4& proj,
-                       float fov)
+                       gl::Texture* texNormal)
 {
     {
         // AO pass
         Binder<gl::Fbo> binder(fboAo);
-        progAo.bind().setUniform("texDepth",    0)
-                     .setUniform("texNormal",   1)
-                     .setUniform("texNoise",    2)
-                     .setUniform("kernelSize",  kernelSize)
-                     .setUniform("kernel",      kernel)
-                     .setUniform("noiseScale",  noiseScale())
-                     .setUniform("p",           proj)
-                     .setUniform("tanHalfFov",  std::tan(0.5f * fov))
-                     .setUniform("aspectRatio", renderSize.aspect<float>());
+        progAo.bind().setUniform("texDepth",   0)
+                     .setUniform("texNormal",  1)
+                     .setUniform("texNoise",   2)
+                     .setUniform("kernelSize", kernelSize)
+                     .setUniform("kernel",     kernel)
+                     .setUniform("noiseScale", noiseScale());
 
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         glViewport(0, 0, renderSize.w, renderSize.h);
 
         texDepth->bindAs(GL_TEXTURE0);
@@ -12,6 +12,7 @@
 #include "gl/fbo.h"
 
 #include "blur.h"
+#include "frame_graph.h"
 
 namespace pt
 {
@@ -45,14 +46,13 @@ struct Ssao
     Blur              blur;
 
     Ssao(int kernelSize, const Size<int>& displaySize,
-                         const Size<int>& renderSize);
+                         const Size<int>& renderSize,
+                         FrameGraph& graph);
 
     glm::vec2 noiseScale() const;
 
     Ssao& operator()(gl::Texture* texDepth,
-                     gl::Texture* texNormal,
-                     const glm::mat4& proj,
-                     float fov);
+                     gl::Texture* texNormal);
 
     gl::Texture& output();
 };
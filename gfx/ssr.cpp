@@ -4,13 +4,15 @@
 
 #include "platform/clock.h"
 #include "common/log.h"
+#include "gl/state.h"
 
 namespace pt
 {
 namespace gfx
 {
 
-Ssr::Ssr(const Size<int>& displaySize, const Size<int>& renderSize) :
+Ssr::Ssr(const Size<int>& displaySize, const Size<int>& renderSize,
+         FrameGraph& graph) :
     displaySize(displaySize),
     renderSize(renderSize),
     scale(float(renderSize.w) / displaySize.w),
@@ -25,17 +27,13 @@ Ssr::Ssr(const Size<int>& displaySize, const Size<int>& renderSize) :
             {{0, "position"}, {1, "uv"}})
 {
     // SSR
-    auto ssrSize = {renderSize.w, renderSize.h};
-    texSsrUva.bind().alloc(ssrSize, GL_RGB16F, GL_RGB, GL_FLOAT)
-                    .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                    .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texSsrUva = graph.texture("ssr-uva");
     fboSsr.bind()
           .attach(texSsrUva, gl::Fbo::Attachment::Color)
           .unbind();
 
     // Composite
-    auto outputSize = {displaySize.w, displaySize.h};
-    texComp.bind().alloc(outputSize, GL_RGB16F, GL_RGB, GL_FLOAT);
+    texComp = graph.texture("ssr");
     fboComp.bind()
            .attach(texComp, gl::Fbo::Attachment::Color)
            .unbind();
@@ -58,22 +56,16 @@ Ssr& Ssr::operator()(gl::Texture* texDepth,
         auto tr  = glm::translate({}, glm::vec3(0.5f, 0.5f, 0));
         auto pc  = (sc0 * (tr * sc1)) * camera.matrixProj();
 
-        progSsr.bind().setUniform("texDepth",    0)
-                      .setUniform("texNormal",   1)
-                      .setUniform("z",           0.f)
-                      .setUniform("tanHalfFov",  std::tan(0.5f * camera.fov))
-                      .setUniform("aspectRatio", camera.ar)
-                      .setUniform("v",           camera.matrixView())
-                      .setUniform("p",           camera.matrixProj())
-                      .setUniform("pc",          pc)
-                      .setUniform("zNear",       camera.zNear)
-                      .setUniform("zFar",        camera.zFar);
+        progSsr.bind().setUniform("texDepth",  0)
+                      .setUniform("texNormal", 1)
+                      .setUniform("z",         0.f)
+                      .setUniform("pc",        pc);
 
         glViewport(0, 0, renderSize.w, renderSize.h);
         const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0,
                                       GL_COLOR_ATTACHMENT1};
         glDrawBuffers(2, drawBuffers);
-        glDisable(GL_DEPTH_TEST);
+        gl::State::disable(GL_DEPTH_TEST);
         glDepthMask(GL_FALSE);
         texDepth->bindAs(GL_TEXTURE0);
         texNormal->bindAs(GL_TEXTURE1);
@@ -82,14 +74,12 @@ Ssr& Ssr::operator()(gl::Texture* texDepth,
     {
         // Composite
         Binder<gl::Fbo> binder(fboComp);
-        progComp.bind().setUniform("texColor",    0)
-                       .setUniform("texEnv",      1)
-                       .setUniform("texSsrUva",   2)
-                       .setUniform("texLight",    3)
-                       .setUniform("z",           0.f)
-                       .setUniform("tanHalfFov",  std::tan(0.5f * camera.fov))
-                       .setUniform("aspectRatio", camera.ar)
-                       .setUniform("scale",       scale);
+        progComp.bind().setUniform("texColor",  0)
+                       .setUniform("texEnv",    1)
+                       .setUniform("texSsrUva", 2)
+                       .setUniform("texLight",  3)
+                       .setUniform("z",         0.f)
+                       .setUniform("scale",     scale);
 
         glViewport(0, 0, displaySize.w, displaySize.h);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
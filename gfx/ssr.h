@@ -7,6 +7,8 @@
 #include "gl/fbo.h"
 #include "scene/camera.h"
 
+#include "frame_graph.h"
+
 namespace pt
 {
 namespace gfx
@@ -34,7 +36,8 @@ struct Ssr
     gl::Fbo           fboSsr,
                       fboComp;
 
-    Ssr(const Size<int>& displaySize, const Size<int>& renderSize);
+    Ssr(const Size<int>& displaySize, const Size<int>& renderSize,
+        FrameGraph& graph);
 
     Ssr& operator()(gl::Texture* texDepth,
                     gl::Texture* texNormal,
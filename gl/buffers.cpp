@@ -1,5 +1,7 @@
 #include "buffers.h"
 
+#include <algorithm>
+
 #include "common/log.h"
 
 namespace pt
@@ -11,9 +13,10 @@ namespace
 
 GLenum bufferTarget(Buffer::Type type)
 {
-    return type == Buffer::Type::Vertex ? GL_ARRAY_BUFFER :
-           type == Buffer::Type::Index  ? GL_ELEMENT_ARRAY_BUFFER :
-                                          GL_TEXTURE_BUFFER;
+    return type == Buffer::Type::Vertex  ? GL_ARRAY_BUFFER :
+           type == Buffer::Type::Index   ? GL_ELEMENT_ARRAY_BUFFER :
+           type == Buffer::Type::Uniform ? GL_UNIFORM_BUFFER :
+                                           GL_TEXTURE_BUFFER;
 }
 
 GLenum bufferUsage(Buffer::Usage usage)
@@ -34,8 +37,8 @@ GLenum bufferUsage(Buffer::Usage usage)
 
 struct Buffer::Data
 {
-    explicit Data(Buffer::Type type) :
-        id(0), size(0), type(type), usage(Usage::StaticDraw)
+    Data(Buffer::Type type, Buffer::Usage usage) :
+        id(0), size(0), type(type), usage(usage)
     {
         glGenBuffers(1, &id);
     }
@@ -55,8 +58,8 @@ Buffer::Buffer()
 {
 }
 
-Buffer::Buffer(Buffer::Type type) :
-    d(std::make_shared<Data>(type))
+Buffer::Buffer(Buffer::Type type, Buffer::Usage usage) :
+    d(std::make_shared<Data>(type, usage))
 {
 }
 
@@ -104,5 +107,20 @@ Buffer& Buffer::alloc(const void* data, int size)
     return *this;
 }
 
+Buffer& Buffer::update(const void* data, int size)
+{
+    const GLenum target = bufferTarget(d->type);
+
+    glBindBuffer(target, d->id);
+    glBufferSubData(target, 0, std::min(size, d->size), data);
+    return *this;
+}
+
+Buffer& Buffer::bindBase(GLuint index)
+{
+    glBindBufferBase(bufferTarget(d->type), index, d->id);
+    return *this;
+}
+
 } // namespace gl
 } // namespace pt
@@ -15,7 +15,8 @@ struct Buffer
     {
         Vertex,
         Index,
-        Texture
+        Texture,
+        Uniform
     };
 
     enum class Usage
@@ -26,7 +27,7 @@ struct Buffer
     };
 
     Buffer();
-    Buffer(Type type);
+    Buffer(Type type, Usage usage = Usage::StaticDraw);
 
     operator bool() const;
 
@@ -36,6 +37,10 @@ struct Buffer
     Buffer& bind();
     Buffer& unbind();
     Buffer& alloc(const void* data, int size);
+    // Overwrites the start of the allocated storage
+    Buffer& update(const void* data, int size);
+    // Binds to an indexed target, uniform buffers to a block binding
+    Buffer& bindBase(GLuint index);
 
 private:
     struct Data;
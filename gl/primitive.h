@@ -1,8 +1,11 @@
 #pragma once
 
+#include <glm/mat4x4.hpp>
+
 #include "common/common.h"
 #include "geom/mesh.h"
 #include "buffers.h"
+#include "state.h"
 #include "vao.h"
 
 namespace pt
@@ -16,8 +19,9 @@ struct Primitive
     {}
 
     template <typename V, typename I>
-    explicit Primitive(const Mesh<V, I>& mesh) :
-       vertexSpec {V::spec()}, indexSpec {sizeof(I)},
+    explicit Primitive(const Mesh<V, I>& mesh,
+                       const glm::mat4& unpack = glm::mat4(1.f)) :
+       vertexSpec {V::spec()}, indexSpec {sizeof(I)}, unpack(unpack),
        vertices(Buffer::Type::Vertex),
        indices(Buffer::Type::Index)
     {
@@ -44,6 +48,7 @@ struct Primitive
             const auto count = std::get<0>(attrib);
             const auto type  = std::get<1>(attrib);
             const auto size  = std::get<2>(attrib);
+            const auto norm  = std::get<3>(attrib);
 
             if (type == GL_INT)
                 glVertexAttribIPointer(GLuint(i), GLint(count), type,
@@ -51,7 +56,8 @@ struct Primitive
                                        reinterpret_cast<const void*>(offset));
             else
                 glVertexAttribPointer(GLuint(i), GLint(count), type,
-                                      GL_FALSE, GLsizei(stride),
+                                      norm ? GL_TRUE : GL_FALSE,
+                                      GLsizei(stride),
                                       reinterpret_cast<const void*>(offset));
             offset += size;
         }
@@ -64,11 +70,12 @@ struct Primitive
 
     void render(GLenum mode = GL_TRIANGLES, GLenum cull = GL_BACK) const
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(cull);
+        State::enable(GL_CULL_FACE);
+        State::cullFace(cull);
 
-        // Draw elements with VAO
-        Binder<gl::Vao> binder(vao);
+        // Draw elements with VAO, left bound for the next draw
+        vao.bind();
+        State::countDraw();
         glDrawElements(mode,
                        indices.size() / int(indexSpec.size),
                        indexSpec.size == 4 ? GL_UNSIGNED_INT :
@@ -80,6 +87,9 @@ struct Primitive
     VertexSpec  vertexSpec;
     IndexSpec   indexSpec;
 
+    // Maps stored vertex positions to model space
+    glm::mat4   unpack = glm::mat4(1.f);
+
     Buffer      vertices, indices;
 
     mutable
@@ -1,7 +1,11 @@
 #include "shaders.h"
 
+#include <unordered_map>
+#include <utility>
+
 #include "common/common.h"
 #include "common/log.h"
+#include "state.h"
 #include "uniforms.h"
 
 namespace pt
@@ -46,6 +50,48 @@ Shader::Type typeFromExt(const fs::path& path)
                              "type for path: " + path.generic_string());
 }
 
+// Replaces the lines #include "file" with the file, as the GLSL version
+// in use has no includes
+std::string expandIncludes(const std::string& source)
+{
+    const std::string directive = "#include \"";
+
+    std::string expanded;
+    std::size_t begin = 0;
+    while (begin < source.size())
+    {
+        std::size_t end = source.find('\n', begin);
+        end = end == std::string::npos ? source.size() : end + 1;
+
+        const auto line = source.substr(begin, end - begin);
+        const auto last = line.find('"', directive.size());
+        if (line.compare(0, directive.size(), directive) == 0 &&
+            last != std::string::npos)
+        {
+            const auto file = line.substr(directive.size(),
+                                          last - directive.size());
+            expanded += expandIncludes(readFile(Shader::path(file)));
+        }
+        else
+            expanded += line;
+
+        begin = end;
+    }
+    return expanded;
+}
+
+struct SharedBlock
+{
+    Block       block;
+    const char* name;
+    GLint       size;
+};
+
+const SharedBlock blocks[] =
+{
+    {Block::Frame, "Frame", FRAME_BLOCK_SIZE}
+};
+
 } // namespace
 
 struct Shader::Data
@@ -54,11 +100,11 @@ struct Shader::Data
          const std::string& name = std::string()) :
         id(0),
         type(type),
-        source(source)
+        source(expandIncludes(source))
     {
         id = glCreateShader(shaderType(type));
 
-        const GLchar* src = source.c_str();
+        const GLchar* src = this->source.c_str();
         glShaderSource(id, 1, &src, 0);
         glCompileShader(id);
 
@@ -95,10 +141,64 @@ struct ShaderProgram::Data
 
     ~Data()
     {
+        State::deleteProgram(id);
         glDeleteProgram(id);
     }
 
-    GLuint id;
+    // Shared blocks to their binding points, once their size is checked
+    // against the buffer backing them
+    void bindBlocks()
+    {
+        for (const auto& block : blocks)
+        {
+            const auto index = glGetUniformBlockIndex(id, block.name);
+            if (index == GL_INVALID_INDEX)
+                continue;
+
+            // Drivers may leave out the padding of the last vec4
+            GLint size = 0;
+            glGetActiveUniformBlockiv(id, index, GL_UNIFORM_BLOCK_DATA_SIZE,
+                                      &size);
+            if ((size + 15) / 16 * 16 != block.size)
+            {
+                PTLOG(Error) << "Uniform block " << block.name << " size "
+                             << size << ", expected " << block.size;
+                throw std::runtime_error("Uniform block size mismatch");
+            }
+            glUniformBlockBinding(id, index, GLuint(block.block));
+        }
+    }
+
+    // Active uniform locations, arrays also by their name without index
+    void locate()
+    {
+        GLint count = 0, length = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &length);
+
+        std::string name(length, 0);
+        for (GLuint i = 0; i < GLuint(count); ++i)
+        {
+            GLsizei nameLength = 0;
+            GLint   size;
+            GLenum  type;
+            glGetActiveUniform(id, i, length, &nameLength, &size, &type,
+                               &name[0]);
+
+            const auto uniform  = name.substr(0, nameLength);
+            const auto location = glGetUniformLocation(id, uniform.c_str());
+            if (location < 0)
+                continue;
+
+            locations[uniform] = location;
+            const auto index   = uniform.find("[0]");
+            if (index != std::string::npos)
+                locations[uniform.substr(0, index)] = location;
+        }
+    }
+
+    GLuint                                 id;
+    std::unordered_map<std::string, GLint> locations;
 };
 
 Shader::Shader(Type type, const std::string& s) :
@@ -152,6 +252,8 @@ ShaderProgram::ShaderProgram(const std::vector<Shader>& shaders,
         PTLOG(Error) << infoLog;
         throw std::runtime_error("Program compilation error");
     }
+    d->bindBlocks();
+    d->locate();
 }
 
 GLuint ShaderProgram::id() const
@@ -161,15 +263,22 @@ GLuint ShaderProgram::id() const
 
 ShaderProgram& ShaderProgram::bind()
 {
-    glUseProgram(d->id);
+    State::useProgram(d->id);
     return *this;
 }
 
 ShaderProgram& ShaderProgram::unbind()
 {
-    glUseProgram(0);
+    State::useProgram(0);
     return *this;
 }
 
+GLint ShaderProgram::location(const char* name) const
+{
+    State::countUniform();
+    const auto it = d->locations.find(name);
+    return it != d->locations.end() ? it->second : -1;
+}
+
 } // namespace gl
 } // namespace pt
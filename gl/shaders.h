@@ -21,6 +21,7 @@ struct Shader
         Mesh
     };
 
+    // Lines #include "file" are replaced with the file from path()
     Shader(Type type, const std::string& s);
     Shader(Type type, const fs::path& path);
     Shader(const fs::path& path);
@@ -34,6 +35,16 @@ private:
     std::shared_ptr<Data> d;
 };
 
+// Binding points of the uniform blocks shared by programs, a block declared
+// by a program is bound to its point at link
+enum class Block : GLuint
+{
+    Frame
+};
+
+// std140 size of the Frame block, shaders/frame.glsl
+constexpr GLint FRAME_BLOCK_SIZE = 320;
+
 struct ShaderProgram
 {
     typedef std::pair<int, std::string> AttribLocation;
@@ -46,6 +57,9 @@ struct ShaderProgram
     ShaderProgram& bind();
     ShaderProgram& unbind();
 
+    // Location of an active uniform, -1 if there is none by the name
+    GLint location(const char* name) const;
+
     template<typename T>
     ShaderProgram& setUniform(const char* name, const T& v);
 
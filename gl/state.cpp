@@ -0,0 +1,176 @@
+#include "state.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace pt
+{
+namespace gl
+{
+namespace State
+{
+namespace
+{
+
+constexpr GLuint UNKNOWN = ~0u;
+
+struct Cache
+{
+    GLuint program  = UNKNOWN;
+    GLuint vao      = UNKNOWN;
+    GLenum unit     = 0;
+    GLenum cullFace = 0;
+
+    // Texture by unit and target, and capabilities, unknown when missing
+    std::unordered_map<uint64_t, GLuint> textures;
+    std::unordered_map<GLenum, bool>     caps;
+
+    Counts counts;
+};
+
+Cache& cache()
+{
+    static Cache cache;
+    return cache;
+}
+
+// Whether the cached value changes, counting the call issued or skipped
+template <typename T>
+bool change(T& cached, T value)
+{
+    auto& counts = cache().counts;
+    if (cached == value)
+    {
+        ++counts.skipped;
+        return false;
+    }
+    cached = value;
+    ++counts.calls;
+    return true;
+}
+
+void capability(GLenum cap, bool enabled)
+{
+    auto& caps = cache().caps;
+    auto it    = caps.find(cap);
+    if (it == caps.end())
+    {
+        caps[cap] = enabled;
+        ++cache().counts.calls;
+    }
+    else
+    if (!change(it->second, enabled))
+        return;
+
+    if (enabled)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+} // namespace
+
+void useProgram(GLuint program)
+{
+    if (change(cache().program, program))
+        glUseProgram(program);
+}
+
+void bindVertexArray(GLuint vao)
+{
+    if (change(cache().vao, vao))
+        glBindVertexArray(vao);
+}
+
+void activeTexture(GLenum unit)
+{
+    if (change(cache().unit, unit))
+        glActiveTexture(unit);
+}
+
+void bindTexture(GLenum target, GLuint texture)
+{
+    const auto key = uint64_t(cache().unit) << 32 | target;
+    auto& textures = cache().textures;
+    auto it        = textures.find(key);
+    if (it == textures.end())
+    {
+        textures[key] = texture;
+        ++cache().counts.calls;
+    }
+    else
+    if (!change(it->second, texture))
+        return;
+
+    glBindTexture(target, texture);
+}
+
+void enable(GLenum cap)
+{
+    capability(cap, true);
+}
+
+void disable(GLenum cap)
+{
+    capability(cap, false);
+}
+
+void cullFace(GLenum mode)
+{
+    if (change(cache().cullFace, mode))
+        glCullFace(mode);
+}
+
+void deleteProgram(GLuint program)
+{
+    if (cache().program == program)
+        cache().program = UNKNOWN;
+}
+
+void deleteVertexArray(GLuint vao)
+{
+    if (cache().vao == vao)
+        cache().vao = 0;
+}
+
+void deleteTexture(GLuint texture)
+{
+    for (auto& bound : cache().textures)
+        if (bound.second == texture)
+            bound.second = 0;
+}
+
+void reset()
+{
+    auto& c    = cache();
+    c.program  = UNKNOWN;
+    c.vao      = UNKNOWN;
+    c.unit     = 0;
+    c.cullFace = 0;
+    c.textures.clear();
+    c.caps.clear();
+}
+
+void countDraw()
+{
+    ++cache().counts.draws;
+}
+
+void countUniform()
+{
+    ++cache().counts.uniforms;
+}
+
+Counts counts()
+{
+    return cache().counts;
+}
+
+void resetCounts()
+{
+    cache().counts = Counts();
+}
+
+} // namespace State
+} // namespace gl
+} // namespace pt
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace pt
+{
+namespace gl
+{
+
+// GL calls issued and skipped as redundant, draws and uniforms set
+struct Counts
+{
+    int calls    = 0;
+    int skipped  = 0;
+    int draws    = 0;
+    int uniforms = 0;
+};
+
+// Cache of the bound program, vertex array, textures per unit and enabled
+// capabilities. Calls that would leave the cached state as is are skipped,
+// so these have to go through here. GL use outside of it, such as NanoVG,
+// is followed by reset().
+namespace State
+{
+
+void useProgram(GLuint program);
+void bindVertexArray(GLuint vao);
+
+void activeTexture(GLenum unit);
+// Binds to the active unit
+void bindTexture(GLenum target, GLuint texture);
+
+void enable(GLenum cap);
+void disable(GLenum cap);
+void cullFace(GLenum mode);
+
+// Objects being deleted, unbound as GL does
+void deleteProgram(GLuint program);
+void deleteVertexArray(GLuint vao);
+void deleteTexture(GLuint texture);
+
+// Forgets the state, the next call of each kind is issued
+void reset();
+
+void countDraw();
+void countUniform();
+
+// Counts since the last resetCounts()
+Counts counts();
+void resetCounts();
+
+} // namespace State
+} // namespace gl
+} // namespace pt
@@ -3,6 +3,7 @@
 #include <glm/gtc/constants.hpp>
 
 #include "common/log.h"
+#include "state.h"
 
 namespace pt
 {
@@ -31,6 +32,32 @@ GLenum textureTarget(Texture::Type type)
     return types.at(index);
 }
 
+// Internal and pixel formats of 8-bit images by depth
+struct ImageFormat
+{
+    GLenum internalFormat;
+    GLenum format;
+};
+
+ImageFormat imageFormat(int depth, bool srgb)
+{
+    const ImageFormat formats[] =
+    {
+        {GL_R8,                             GL_RED},
+        {GL_RG8,                            GL_RG},
+        {srgb ? GL_SRGB8        : GL_RGB8,  GL_RGB},
+        {srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, GL_RGBA}
+    };
+    return formats[depth - 1];
+}
+
+// Unpacks byte rows of a stride, or restores the defaults without one
+void unpackRows(int stride = 0, int depth = 1)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  stride ? 1 : 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / depth);
+}
+
 } // namespace
 
 struct Texture::Data
@@ -44,6 +71,7 @@ struct Texture::Data
 
     ~Data()
     {
+        State::deleteTexture(id);
         glDeleteTextures(1, &id);
     }
 
@@ -115,26 +143,26 @@ Image Texture::image()
 
 Texture& Texture::bind()
 {
-    glBindTexture(d->target, d->id);
+    State::bindTexture(d->target, d->id);
     return *this;
 }
 
 Texture& Texture::bindAs(GLenum unit)
 {
-    glActiveTexture(unit);
+    State::activeTexture(unit);
     return bind();
 }
 
 Texture& Texture::unbind()
 {
-    glBindTexture(d->target, 0);
+    State::bindTexture(d->target, 0);
     return *this;
 }
 
 void Texture::unbind(GLenum target, GLenum unit)
 {
-    glActiveTexture(unit);
-    glBindTexture(target, 0);
+    State::activeTexture(unit);
+    State::bindTexture(target, 0);
 }
 
 Texture& Texture::set(GLenum name, GLenum param)
@@ -187,7 +215,8 @@ Texture& Texture::alloc(int level, const std::vector<int>& dim,
                                 internalFormat,
                                 dim[0], dim[1], GL_TRUE);
     else
-    if (d->target == GL_TEXTURE_3D && dim.size() > 2)
+    if ((d->target == GL_TEXTURE_3D || d->target == GL_TEXTURE_2D_ARRAY) &&
+        dim.size() > 2)
         glTexImage3D(d->target,
                      level, internalFormat,
                      dim[0], dim[1], dim[2], 0, format, type, data);
@@ -206,27 +235,85 @@ Texture& Texture::alloc(int level, const std::vector<int>& dim,
 
 Texture& Texture::alloc(const Image& image, bool srgb)
 {
-    struct Format
+    if (image.depth() > 0 && image.depth() <= 4)
     {
-        int internalFormat;
-        int format;
+        // Views upload straight from the memory they share
+        const auto f = imageFormat(image.depth(), srgb);
+        unpackRows(image.stride(), image.depth());
+        alloc({image.size().w, image.size().h},
+              f.internalFormat, f.format, GL_UNSIGNED_BYTE, image.bits());
+        unpackRows();
     }
-    const formats[] =
+    return *this;
+}
+
+Texture& Texture::alloc(const std::vector<Image>& layers, bool srgb,
+                        int level)
+{
+    if (!layers.empty() && layers[0].depth() > 0 && layers[0].depth() <= 4)
     {
-        {GL_R8,                             GL_RED},
-        {GL_RG8,                            GL_RG},
-        {srgb ? GL_SRGB8        : GL_RGB8,  GL_RGB},
-        {srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, GL_RGBA}
-    };
-    if (image.depth() > 0 && image.depth() <= 4)
+        const auto& image = layers[0];
+        const auto f      = imageFormat(image.depth(), srgb);
+        alloc(level, {image.size().w, image.size().h, int(layers.size())},
+              f.internalFormat, f.format);
+
+        for (int i = 0; i < int(layers.size()); ++i)
+            update(layers[i], 0, 0, i, level);
+    }
+    return *this;
+}
+
+Texture& Texture::update(const Image& image, int x, int y, int layer,
+                         int level)
+{
+    if (!image || image.depth() <= 0 || image.depth() > 4)
+        return *this;
+
+    const auto f = imageFormat(image.depth(), false);
+    unpackRows(image.stride(), image.depth());
+    if (d->target == GL_TEXTURE_2D)
+        glTexSubImage2D(d->target, level, x, y,
+                        image.size().w, image.size().h,
+                        f.format, GL_UNSIGNED_BYTE, image.bits());
+    else
+    if (d->target == GL_TEXTURE_2D_ARRAY)
+        glTexSubImage3D(d->target, level, x, y, layer,
+                        image.size().w, image.size().h, 1,
+                        f.format, GL_UNSIGNED_BYTE, image.bits());
+    unpackRows();
+    return *this;
+}
+
+Texture& Texture::allocCompressed(const std::vector<int>& dim,
+                                  GLenum internalFormat, int imageSize,
+                                  int level)
+{
+    if (d->target == GL_TEXTURE_2D_ARRAY && dim.size() > 2)
     {
-        const Format f = formats[image.depth() - 1];
-        return alloc({image.size().w, image.size().h},
-                      f.internalFormat, f.format, GL_UNSIGNED_BYTE, image.bits());
+        glCompressedTexImage3D(d->target, level, internalFormat,
+                               dim[0], dim[1], dim[2], 0, imageSize, nullptr);
+
+        set(GL_TEXTURE_MIN_FILTER, GLint(GL_NEAREST));
+        set(GL_TEXTURE_MAG_FILTER, GLint(GL_NEAREST));
+        set(GL_TEXTURE_WRAP_S,     GLint(GL_CLAMP_TO_EDGE));
+        set(GL_TEXTURE_WRAP_T,     GLint(GL_CLAMP_TO_EDGE));
     }
     return *this;
 }
 
+Texture& Texture::updateCompressed(int x, int y, int layer,
+                                   const Size<int>& size,
+                                   GLenum internalFormat,
+                                   const std::vector<uint8_t>& blocks,
+                                   int level)
+{
+    if (d->target == GL_TEXTURE_2D_ARRAY)
+        glCompressedTexSubImage3D(d->target, level, x, y, layer,
+                                  size.w, size.h, 1, internalFormat,
+                                  GLsizei(blocks.size()), blocks.data());
+    return *this;
+}
+
 Texture& Texture::alloc(const Grid<float>& grid)
 {
     return alloc(grid.dims(), GL_R32F, GL_RED, GL_FLOAT, grid.ptr());
@@ -249,5 +336,13 @@ float Texture::anisotropyMax()
     return f;
 }
 
+bool Texture::supported(GLenum internalFormat)
+{
+    GLint supported = GL_FALSE;
+    glGetInternalformativ(GL_TEXTURE_2D_ARRAY, internalFormat,
+                          GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+    return supported == GL_TRUE;
+}
+
 } // namespace gl
 } // namespace pt
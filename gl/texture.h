@@ -64,11 +64,28 @@ struct Texture
                    GLenum type = GL_UNSIGNED_BYTE, const GLvoid* data = nullptr);
 
     Texture& alloc(const Image& image, bool srgb = true);
+    // 2D array level with a layer per image, all of the same size and depth
+    Texture& alloc(const std::vector<Image>& layers, bool srgb = true,
+                   int level = 0);
+    // Replaces the region at x, y of a 2D texture or 2D array layer
+    Texture& update(const Image& image, int x, int y,
+                    int layer = 0, int level = 0);
+    // Compressed 2D array level of blank layers, imageSize bytes in total
+    Texture& allocCompressed(const std::vector<int>& dim,
+                             GLenum internalFormat, int imageSize,
+                             int level = 0);
+    // Replaces the block-aligned region at x, y of a compressed layer
+    Texture& updateCompressed(int x, int y, int layer, const Size<int>& size,
+                              GLenum internalFormat,
+                              const std::vector<uint8_t>& blocks,
+                              int level = 0);
+
     Texture& alloc(const Grid<float>& grid);
     Texture& alloc(const Grid<glm::vec3>& grid);
     Texture& alloc(const Grid<glm::vec4>& grid);
 
     static float anisotropyMax();
+    static bool supported(GLenum internalFormat);
 
 private:
     struct Data;
@@ -1,60 +1,329 @@
 #include "texture_atlas.h"
 
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #include "platform/clock.h"
 #include "common/log.h"
 
+// S3TC formats, an extension to core profiles
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT        0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT       0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 namespace pt
 {
 namespace gl
 {
 
-TextureAtlas::TextureAtlas(const Size<int>& size, bool srgb, int margin) :
-    atlas(size), srgb(srgb), margin(margin)
+namespace
+{
+
+GLenum internalFormat(BlockCodec::Format format, bool srgb)
+{
+    using BlockCodec::Format;
+    switch (format)
+    {
+        case Format::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT :
+                                        GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case Format::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT :
+                                        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+        default:          return GL_NONE;
+    }
+}
+
+// Gutter for bilinear lookups at the content edge of the last level. Entry
+// rects round inward by up to a texel per level, so the gutter takes one and
+// a half texels there.
+int mipMargin(int levels)
+{
+    return levels > 1 ? 3 << (levels - 2) : 1;
+}
+
+// Rect of an entry at a mip level, rounded inward so entries stay disjoint
+Rect<int> entryRect(const Rect<int>& rect, int level)
+{
+    const int x0 = (rect.x + (1 << level) - 1) >> level;
+    const int y0 = (rect.y + (1 << level) - 1) >> level;
+    const int x1 = (rect.x + rect.size.w) >> level;
+    const int y1 = (rect.y + rect.size.h) >> level;
+    return Rect<int>(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+// Rect of the entry content at a mip level, rounded outward into the gutter
+Rect<int> contentRect(const Rect<int>& rect, int margin, int level)
+{
+    const auto c = rect.extended(-margin, -margin);
+    const auto e = entryRect(rect, level);
+    const int x0 = std::max(e.x, c.x >> level);
+    const int y0 = std::max(e.y, c.y >> level);
+    const int x1 = std::min(e.x + e.size.w,
+                            (c.x + c.size.w + (1 << level) - 1) >> level);
+    const int y1 = std::min(e.y + e.size.h,
+                            (c.y + c.size.h + (1 << level) - 1) >> level);
+    return Rect<int>(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+inline int clamp(int v, int begin, int size)
+{
+    return std::min(std::max(v, begin), begin + size - 1);
+}
+
+// Box filters an entry from the level above, clamping the footprint to the
+// source content. Gutter texels repeat the nearest content texel.
+void downsample(const Image& src, Image& dst, const Rect<int>& rect,
+                int margin, int level)
 {
-    // Update initial texture
+    const auto sc = contentRect(rect, margin, level - 1);
+    const auto dc = contentRect(rect, margin, level);
+    const auto de = entryRect(rect, level);
+    if (!sc.size || !dc.size)
+        return;
+
+    #pragma omp parallel for
+    for (int y = de.y; y < de.y + de.size.h; ++y)
+    {
+        const int cy  = clamp(y,          dc.y, dc.size.h);
+        const int sy0 = clamp(2 * cy,     sc.y, sc.size.h);
+        const int sy1 = clamp(2 * cy + 1, sc.y, sc.size.h);
+        for (int x = de.x; x < de.x + de.size.w; ++x)
+        {
+            const int cx  = clamp(x,          dc.x, dc.size.w);
+            const int sx0 = clamp(2 * cx,     sc.x, sc.size.w);
+            const int sx1 = clamp(2 * cx + 1, sc.x, sc.size.w);
+
+            const uint8_t* p00 = src.bits(sx0, sy0);
+            const uint8_t* p10 = src.bits(sx1, sy0);
+            const uint8_t* p01 = src.bits(sx0, sy1);
+            const uint8_t* p11 = src.bits(sx1, sy1);
+            uint8_t*       p   = dst.bits(x, y);
+            for (int c = 0; c < 4; ++c)
+                p[c] = uint8_t((p00[c] + p10[c] + p01[c] + p11[c] + 2) >> 2);
+        }
+    }
+}
+
+} // namespace
+
+TextureAtlas::TextureAtlas(const Size<int>& size, bool srgb, int margin,
+                           BlockCodec::Format format) :
+    size(size), pages{ImageAtlas(size)},
+    texture(Texture::Type::Array2d), srgb(srgb),
+    margin(std::max(margin, mipMargin(mipLevels))),
+    format(format), layers(0)
+{
+    if (format != BlockCodec::Format::None &&
+        !Texture::supported(internalFormat(format, srgb)))
+    {
+        PTLOG(Warn) << "Block compression not supported, using RGBA8";
+        this->format = BlockCodec::Format::None;
+    }
+
+    // Allocate initial texture
     update();
 }
 
 void TextureAtlas::update()
 {
-    texture.bind().alloc(atlas.image(), srgb)
-                  .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-                  .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR)
-                  .set(GL_TEXTURE_MAX_ANISOTROPY, Texture::anisotropyMax());
+    // Mip images follow the pages
+    while (mips.size() < pages.size())
+    {
+        std::vector<Image> levels;
+        for (int level = 1; level < mipLevels; ++level)
+            levels.push_back(Image(Size<int>(size.w >> level,
+                                             size.h >> level), 4).
+                             fill(0xff000000));
+        mips.push_back(levels);
+    }
+    mips.resize(pages.size());
+
+    // Rebuild the mips of changed entries, finest level first
+    for (const auto& entry : dirty)
+        for (int level = 1; level < mipLevels; ++level)
+            downsample(levelImage(entry.first, level - 1),
+                       mips[entry.first][level - 1],
+                       entry.second, margin, level);
+
+    // Reallocate when pages were added or dropped
+    if (int(pages.size()) != layers)
+    {
+        texture.bind();
+        for (int level = 0; level < mipLevels; ++level)
+        {
+            std::vector<Image> images;
+            for (int layer = 0; layer < int(pages.size()); ++layer)
+                images.push_back(levelImage(layer, level));
+
+            const Size<int> levelSize(size.w >> level, size.h >> level);
+            if (format == BlockCodec::Format::None)
+                texture.alloc(images, srgb, level);
+            else
+            {
+                const auto fmt   = internalFormat(format, srgb);
+                const auto bytes = BlockCodec::encodedSize(format, levelSize);
+                texture.allocCompressed({levelSize.w, levelSize.h,
+                                         int(images.size())},
+                                        fmt, int(bytes * images.size()), level);
+                for (int layer = 0; layer < int(images.size()); ++layer)
+                    texture.updateCompressed(
+                        0, 0, layer, levelSize, fmt,
+                        BlockCodec::encode(images[layer], format), level);
+            }
+        }
+        texture.set(GL_TEXTURE_BASE_LEVEL, 0)
+               .set(GL_TEXTURE_MAX_LEVEL, mipLevels - 1)
+               .set(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR)
+               .set(GL_TEXTURE_MAG_FILTER, GL_LINEAR)
+               .set(GL_TEXTURE_MAX_ANISOTROPY, Texture::anisotropyMax());
+        layers = int(pages.size());
+        dirty.clear();
+        return;
+    }
+    if (dirty.empty())
+        return;
+
+    texture.bind();
+    for (int layer = 0; layer < layers; ++layer)
+        for (int level = 0; level < mipLevels; ++level)
+        {
+            // Upload the bounds of the layer at once unless they are sparse
+            std::vector<Rect<int>> rects;
+            int x0 = size.w, y0 = size.h, x1 = 0, y1 = 0, area = 0;
+            for (const auto& entry : dirty)
+                if (entry.first == layer)
+                {
+                    const auto rect = entryRect(entry.second, level);
+                    x0    = std::min(x0, rect.x);
+                    y0    = std::min(y0, rect.y);
+                    x1    = std::max(x1, rect.x + rect.size.w);
+                    y1    = std::max(y1, rect.y + rect.size.h);
+                    area += rect.area();
+                    rects.push_back(rect);
+                }
+            if (rects.empty())
+                break;
+
+            const Rect<int> bounds(x0, y0, x1 - x0, y1 - y0);
+            if (bounds.area() <= 2 * area)
+                rects = {bounds};
+
+            for (const auto& rect : rects)
+                if (rect.size)
+                    upload(layer, level, rect);
+        }
+    dirty.clear();
+}
+
+Image TextureAtlas::levelImage(int layer, int level) const
+{
+    return level ? mips[layer][level - 1] : pages[layer].image();
+}
+
+void TextureAtlas::upload(int layer, int level, const Rect<int>& rect)
+{
+    const Image image = levelImage(layer, level);
+    if (format == BlockCodec::Format::None)
+    {
+        texture.update(image.view(rect), rect.x, rect.y, layer, level);
+        return;
+    }
+
+    // Encode the blocks covering the rect only
+    const auto levelSize = image.size();
+    const int right      = rect.x + rect.size.w;
+    const int bottom     = rect.y + rect.size.h;
+    const int bx0        = rect.x & ~3;
+    const int by0        = rect.y & ~3;
+    const int bx1        = std::min(levelSize.w, (right  + 3) & ~3);
+    const int by1        = std::min(levelSize.h, (bottom + 3) & ~3);
+    const Rect<int> blocks(bx0, by0, bx1 - bx0, by1 - by0);
+    texture.updateCompressed(bx0, by0, layer, blocks.size,
+                             internalFormat(format, srgb),
+                             BlockCodec::encode(image.view(blocks), format),
+                             level);
 }
 
 TextureAtlas::EntryCube TextureAtlas::insert(const ImageCube& imageCube)
 {
-    EntryCube entryCube;
-    const Size<int> size(atlas.size());
-    for (std::size_t i = 0; i < imageCube.sides.size(); ++i)
+    // Whole cubes go on the first page they fit, so a model samples one
+    // layer
+    for (int layer = 0; ; ++layer)
     {
-        const Rect<int> ri   = atlas.insert(imageCube.side(ImageCube::Side(i)),
-                                            margin);
-        const Rect<float> rt = ri.extended(-margin, -margin)
-                                 .as<Rect<float>>().scaled(1.f / size.w,
-                                                           1.f / size.h);
-        entryCube.first[i]   = ri;
-        entryCube.second[i]  = rt;
+        const bool added = layer == int(pages.size());
+        if (added)
+            pages.emplace_back(size);
+
+        auto& page = pages[layer];
+        EntryCube entryCube;
+        entryCube.layer = layer;
+        for (std::size_t i = 0; i < imageCube.sides.size(); ++i)
+        {
+            const auto& side     = imageCube.side(ImageCube::Side(i));
+            const Rect<int> ri   = page.insert(side, margin);
+            const Rect<float> rt = ri.extended(-margin, -margin)
+                                     .as<Rect<float>>().scaled(1.f / size.w,
+                                                               1.f / size.h);
+            entryCube.rects[i]   = ri;
+            entryCube.uvs[i]     = rt;
+        }
+
+        const bool fits = std::all_of(entryCube.rects.begin(),
+                                      entryCube.rects.end(),
+                                      [](const Rect<int>& r) {return r.size;});
+        if (fits)
+        {
+            for (const auto& rect : entryCube.rects)
+                dirty.emplace_back(layer, rect);
+            return entryCube;
+        }
+
+        for (const auto& rect : entryCube.rects)
+            page.remove(rect);
+
+        // Too large for an empty page
+        if (page.occupancy() == 0.f)
+        {
+            PTLOG(Warn) << "Cube does not fit atlas page of "
+                        << size.w << "x" << size.h;
+            if (added && layer > 0)
+                pages.pop_back();
+            return EntryCube();
+        }
     }
-    // Update texture. TODO: Only update dirty regions.
-    update();
-    return entryCube;
 }
 
 TextureAtlas& TextureAtlas::remove(const TextureAtlas::EntryCube& entry)
 {
-    for (const auto& side : entry.first)
-        atlas.remove(side);
+    if (entry.layer < 0 || entry.layer >= int(pages.size()))
+        return *this;
+
+    for (const auto& side : entry.rects)
+        pages[entry.layer].remove(side);
+
+    // Keep memory proportional to the content
+    while (pages.size() > 1 && pages.back().occupancy() == 0.f)
+        pages.pop_back();
+
+    // Changes on dropped pages have nothing to upload to
+    const int count = int(pages.size());
+    dirty.erase(std::remove_if(dirty.begin(), dirty.end(),
+                    [count](const std::pair<int, Rect<int>>& entry)
+                    {
+                        return entry.first >= count;
+                    }),
+                dirty.end());
 
     return *this;
 }
 
 bool valid(const TextureAtlas::EntryCube& entry)
 {
-    return entry.first[0].size;
+    return entry.layer >= 0 && entry.rects[0].size;
 }
 
 } // namespace gl
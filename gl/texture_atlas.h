@@ -2,8 +2,10 @@
 
 #include <utility>
 #include <array>
+#include <vector>
 
 #include "geom/size.h"
+#include "img/block_codec.h"
 #include "img/image_atlas.h"
 #include "gl/texture.h"
 
@@ -12,22 +14,49 @@ namespace pt
 namespace gl
 {
 
+// Atlas pages as layers of a 2D array texture. Pages are added when a cube
+// fits no existing page and trailing empty pages are dropped. Pages are
+// block compressed on upload when the driver supports the format.
+//
+// Mip levels are built per entry within its own rect, so packed cube sides
+// do not bleed into each other. The margin is widened so that bilinear
+// lookups at the content edge stay within the entry at the last level.
 struct TextureAtlas
 {
-    // Image and texture rect cubes
-    typedef std::pair<RectCube<int>, RectCube<float>> EntryCube;
+    static const int mipLevels = 3;
 
-    TextureAtlas(const Size<int>& size, bool srgb, int margin = 0);
+    // Image and texture rect cubes on a page
+    struct EntryCube
+    {
+        RectCube<int>   rects;
+        RectCube<float> uvs;
+        int             layer = -1;
+    };
 
+    TextureAtlas(const Size<int>& size, bool srgb, int margin = 0,
+                 BlockCodec::Format format = BlockCodec::Format::None);
+
+    // Builds the mips of changed entries and uploads them
     void update();
 
     EntryCube insert(const ImageCube& imageCube);
     TextureAtlas& remove(const EntryCube& entry);
 
-    ImageAtlas  atlas;
-    gl::Texture texture;
-    bool        srgb;
-    int         margin;
+    Size<int>                       size;
+    std::vector<ImageAtlas>         pages;
+    std::vector<std::vector<Image>> mips; // Levels 1 and up per page
+    gl::Texture                     texture;
+    bool                            srgb;
+    int                             margin;
+    BlockCodec::Format              format;
+
+    // Layers allocated in the texture, and changed entry rects per layer
+    int                                    layers;
+    std::vector<std::pair<int, Rect<int>>> dirty;
+
+private:
+    Image levelImage(int layer, int level) const;
+    void upload(int layer, int level, const Rect<int>& rect);
 };
 
 bool valid(const TextureAtlas::EntryCube& entry);
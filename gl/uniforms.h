@@ -12,7 +12,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<bool>(
     const char* name, const bool& v)
 {
-    glUniform1i(glGetUniformLocation(id(), name), v);
+    glUniform1i(location(name), v);
     return *this;
 }
 
@@ -20,7 +20,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<int>(
     const char* name, const int& v)
 {
-    glUniform1i(glGetUniformLocation(id(), name), v);
+    glUniform1i(location(name), v);
     return *this;
 }
 
@@ -28,7 +28,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<float>(
     const char* name, const float& v)
 {
-    glUniform1f(glGetUniformLocation(id(), name), v);
+    glUniform1f(location(name), v);
     return *this;
 }
 
@@ -36,7 +36,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<glm::vec2>(
     const char* name, const glm::vec2& v)
 {
-    glUniform2fv(glGetUniformLocation(id(), name),
+    glUniform2fv(location(name),
                  1, glm::value_ptr(v));
     return *this;
 }
@@ -45,7 +45,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<glm::vec3>(
     const char* name, const glm::vec3& v)
 {
-    glUniform3fv(glGetUniformLocation(id(), name),
+    glUniform3fv(location(name),
                  1, glm::value_ptr(v));
     return *this;
 }
@@ -54,7 +54,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<glm::vec4>(
     const char* name, const glm::vec4& v)
 {
-    glUniform4fv(glGetUniformLocation(id(), name),
+    glUniform4fv(location(name),
                  1, glm::value_ptr(v));
     return *this;
 }
@@ -63,7 +63,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<glm::mat3>(
     const char* name, const glm::mat3& v)
 {
-    glUniformMatrix3fv(glGetUniformLocation(id(), name),
+    glUniformMatrix3fv(location(name),
                        1, GL_FALSE, glm::value_ptr(v));
     return *this;
 }
@@ -72,7 +72,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<glm::mat4>(
     const char* name, const glm::mat4& v)
 {
-    glUniformMatrix4fv(glGetUniformLocation(id(), name),
+    glUniformMatrix4fv(location(name),
                        1, GL_FALSE, glm::value_ptr(v));
     return *this;
 }
@@ -81,7 +81,7 @@ template<>
 ShaderProgram& ShaderProgram::setUniform<std::vector<glm::vec3>>(
     const char* name, const std::vector<glm::vec3>& v)
 {
-    glUniform3fv(glGetUniformLocation(id(), name),
+    glUniform3fv(location(name),
                  v.size(), (const GLfloat*) v.data());
     return *this;
 }
@@ -1,5 +1,7 @@
 #include "vao.h"
 
+#include "state.h"
+
 namespace pt
 {
 namespace gl
@@ -14,6 +16,7 @@ struct Vao::Data
 
     ~Data()
     {
+        State::deleteVertexArray(id);
         glDeleteVertexArrays(1, &id);
     }
 
@@ -32,13 +35,13 @@ GLuint Vao::id() const
 
 Vao& Vao::bind()
 {
-    glBindVertexArray(d->id);
+    State::bindVertexArray(d->id);
     return *this;
 }
 
 Vao& Vao::unbind()
 {
-    glBindVertexArray(0);
+    State::bindVertexArray(0);
     return *this;
 }
 
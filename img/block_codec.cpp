@@ -0,0 +1,404 @@
+#include "block_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <glm/glm.hpp>
+
+namespace pt
+{
+namespace BlockCodec
+{
+
+namespace
+{
+
+using Block = uint8_t[16][4];
+
+// Loads a block, replicating edge pixels past the image bounds
+void loadBlock(const Image& image, int bx, int by, Block block)
+{
+    const auto size = image.size();
+    for (int y = 0; y < 4; ++y)
+    {
+        const auto row = image.bits(0, std::min(4 * by + y, size.h - 1));
+        for (int x = 0; x < 4; ++x)
+            std::memcpy(block[4 * y + x],
+                        row + 4 * std::min(4 * bx + x, size.w - 1), 4);
+    }
+}
+
+uint16_t to565(const glm::vec3& c)
+{
+    const auto q = glm::clamp(glm::round(c * glm::vec3(31.f, 63.f, 31.f) /
+                                         255.f),
+                              glm::vec3(0.f), glm::vec3(31.f, 63.f, 31.f));
+    return uint16_t((int(q.r) << 11) | (int(q.g) << 5) | int(q.b));
+}
+
+glm::ivec3 from565(uint16_t c)
+{
+    const int r = c >> 11, g = (c >> 5) & 63, b = c & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// Four-color palette of two endpoints
+void palette(uint16_t c0, uint16_t c1, glm::ivec3 colors[4])
+{
+    colors[0] = from565(c0);
+    colors[1] = from565(c1);
+    colors[2] = (2 * colors[0] + colors[1]) / 3;
+    colors[3] = (colors[0] + 2 * colors[1]) / 3;
+}
+
+// Nearest palette indices, returning the squared error
+int colorIndices(const Block block, uint16_t c0, uint16_t c1, int indices[16])
+{
+    glm::ivec3 colors[4];
+    palette(c0, c1, colors);
+
+    int error = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        const glm::ivec3 c(block[i][0], block[i][1], block[i][2]);
+        int best = 0, bestError = std::numeric_limits<int>::max();
+        for (int j = 0; j < 4; ++j)
+        {
+            const auto d = c - colors[j];
+            const int  e = d.x * d.x + d.y * d.y + d.z * d.z;
+            if (e < bestError)
+            {
+                best      = j;
+                bestError = e;
+            }
+        }
+        indices[i] = best;
+        error     += bestError;
+    }
+    return error;
+}
+
+// Least squares endpoints of a fixed index assignment. Returns false for
+// degenerate assignments.
+bool refit(const Block block, const int indices[16],
+           glm::vec3& e0, glm::vec3& e1)
+{
+    const float weights[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+
+    float aa = 0.f, bb = 0.f, ab = 0.f;
+    glm::vec3 ax(0.f), bx(0.f);
+    for (int i = 0; i < 16; ++i)
+    {
+        const glm::vec3 c(block[i][0], block[i][1], block[i][2]);
+        const float a = weights[indices[i]];
+        const float b = 1.f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        ax += a * c;
+        bx += b * c;
+    }
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f)
+        return false;
+
+    e0 = (ax * bb - bx * ab) / det;
+    e1 = (bx * aa - ax * ab) / det;
+    return true;
+}
+
+// BC1 color block in four-color mode, endpoints along the principal axis
+void encodeColor(const Block block, uint8_t* out)
+{
+    glm::vec3 mean(0.f), lo(255.f), hi(0.f);
+    for (int i = 0; i < 16; ++i)
+    {
+        const glm::vec3 c(block[i][0], block[i][1], block[i][2]);
+        mean += c;
+        lo    = glm::min(lo, c);
+        hi    = glm::max(hi, c);
+    }
+    mean /= 16.f;
+
+    // Covariance, then the principal axis by power iteration
+    float cov[6] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        const auto d = glm::vec3(block[i][0], block[i][1], block[i][2]) - mean;
+        cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+        cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+    }
+    glm::vec3 axis = hi - lo;
+    for (int i = 0; i < 8; ++i)
+    {
+        axis = {cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b};
+        const float m = std::max(std::max(std::abs(axis.r), std::abs(axis.g)),
+                                 std::abs(axis.b));
+        if (m < 1e-6f)
+            break;
+        axis /= m;
+    }
+
+    float t0 = 0.f, t1 = 0.f;
+    if (glm::dot(axis, axis) > 1e-12f)
+    {
+        axis = glm::normalize(axis);
+        t0 = t1 = glm::dot(glm::vec3(block[0][0], block[0][1], block[0][2]) -
+                           mean, axis);
+        for (int i = 1; i < 16; ++i)
+        {
+            const float t = glm::dot(glm::vec3(block[i][0], block[i][1],
+                                               block[i][2]) - mean, axis);
+            t0 = std::max(t0, t);
+            t1 = std::min(t1, t);
+        }
+    }
+
+    // Inset the extremes, which are rarely hit exactly
+    const float inset = (t0 - t1) / 16.f;
+    uint16_t c0 = to565(mean + (t0 - inset) * axis);
+    uint16_t c1 = to565(mean + (t1 + inset) * axis);
+
+    int indices[16];
+    int error = colorIndices(block, c0, c1, indices);
+
+    glm::vec3 e0, e1;
+    if (error && refit(block, indices, e0, e1))
+    {
+        int refined[16];
+        const uint16_t r0 = to565(e0), r1 = to565(e1);
+        const int refinedError = colorIndices(block, r0, r1, refined);
+        if (refinedError < error)
+        {
+            c0    = r0;
+            c1    = r1;
+            error = refinedError;
+            std::copy(refined, refined + 16, indices);
+        }
+    }
+
+    // c0 > c1 selects four-color mode; swapping reverses pairs of indices
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+        for (auto& i : indices)
+            i ^= 1;
+    }
+    else
+    if (c0 == c1)
+        std::fill(indices, indices + 16, 0);
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+        bits |= uint32_t(indices[i]) << (2 * i);
+
+    out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+    out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+    std::memcpy(out + 4, &bits, 4);
+}
+
+// Eight-value palette of a0 > a1, or six values plus 0 and 255 otherwise
+void palette(int a0, int a1, int values[8])
+{
+    values[0] = a0;
+    values[1] = a1;
+    if (a0 > a1)
+        for (int i = 2; i < 8; ++i)
+            values[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+            values[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        values[6] = 0;
+        values[7] = 255;
+    }
+}
+
+// BC4 block of one channel, endpoints at its extremes
+void encodeChannel(const Block block, int channel, uint8_t* out)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        lo = std::min(lo, int(block[i][channel]));
+        hi = std::max(hi, int(block[i][channel]));
+    }
+
+    int values[8];
+    palette(hi, lo, values);
+
+    uint64_t bits = 0;
+    if (hi > lo)
+        for (int i = 0; i < 16; ++i)
+        {
+            const int v = block[i][channel];
+            int best = 0;
+            for (int j = 1; j < 8; ++j)
+                if (std::abs(values[j] - v) < std::abs(values[best] - v))
+                    best = j;
+            bits |= uint64_t(best) << (3 * i);
+        }
+
+    out[0] = uint8_t(hi);
+    out[1] = uint8_t(lo);
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = uint8_t(bits >> (8 * i));
+}
+
+void decodeColor(const uint8_t* in, uint8_t* pixels, int stride)
+{
+    const uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+    const uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+
+    glm::ivec3 colors[4];
+    palette(c0, c1, colors);
+
+    uint32_t bits;
+    std::memcpy(&bits, in + 4, 4);
+    for (int i = 0; i < 16; ++i)
+    {
+        const auto& c = colors[(bits >> (2 * i)) & 3];
+        uint8_t* p    = pixels + (i / 4) * stride + 4 * (i % 4);
+        p[0] = uint8_t(c.r);
+        p[1] = uint8_t(c.g);
+        p[2] = uint8_t(c.b);
+    }
+}
+
+void decodeChannel(const uint8_t* in, int channel, uint8_t* pixels, int stride)
+{
+    int values[8];
+    palette(in[0], in[1], values);
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= uint64_t(in[2 + i]) << (8 * i);
+
+    for (int i = 0; i < 16; ++i)
+        pixels[(i / 4) * stride + 4 * (i % 4) + channel] =
+            uint8_t(values[(bits >> (3 * i)) & 7]);
+}
+
+} // namespace
+
+int blockBytes(Format format)
+{
+    switch (format)
+    {
+        case Format::BC1: return 8;
+        case Format::BC3: return 16;
+        case Format::BC5: return 16;
+        default:          return 64;
+    }
+}
+
+std::size_t encodedSize(Format format, const Size<int>& size)
+{
+    return std::size_t((size.w + 3) / 4) * ((size.h + 3) / 4) *
+           blockBytes(format);
+}
+
+std::vector<uint8_t> encode(const Image& image, Format format)
+{
+    if (image.depth() != 4)
+        throw std::runtime_error("Not implemented for depth: " +
+                                 std::to_string(image.depth()));
+    if (format == Format::None)
+        throw std::runtime_error("No block format");
+
+    const int bw    = (image.size().w + 3) / 4;
+    const int bh    = (image.size().h + 3) / 4;
+    const int bytes = blockBytes(format);
+    std::vector<uint8_t> blocks(encodedSize(format, image.size()));
+
+    #pragma omp parallel for
+    for (int by = 0; by < bh; ++by)
+        for (int bx = 0; bx < bw; ++bx)
+        {
+            Block block;
+            loadBlock(image, bx, by, block);
+
+            uint8_t* out = blocks.data() + (std::size_t(by) * bw + bx) * bytes;
+            if (format == Format::BC1)
+                encodeColor(block, out);
+            else
+            if (format == Format::BC3)
+            {
+                encodeChannel(block, 3, out);
+                encodeColor(block, out + 8);
+            }
+            else
+            {
+                encodeChannel(block, 0, out);
+                encodeChannel(block, 1, out + 8);
+            }
+        }
+    return blocks;
+}
+
+Image decode(const uint8_t* blocks, Format format, const Size<int>& size)
+{
+    // Decode whole blocks, then crop
+    const int bw    = (size.w + 3) / 4;
+    const int bh    = (size.h + 3) / 4;
+    const int bytes = blockBytes(format);
+
+    Image image(Size<int>(4 * bw, 4 * bh), 4);
+    image.fill(0xff000000);
+
+    #pragma omp parallel for
+    for (int by = 0; by < bh; ++by)
+        for (int bx = 0; bx < bw; ++bx)
+        {
+            const uint8_t* in = blocks + (std::size_t(by) * bw + bx) * bytes;
+            uint8_t* pixels   = image.bits(4 * bx, 4 * by);
+            const int stride  = image.stride();
+            if (format == Format::BC1)
+                decodeColor(in, pixels, stride);
+            else
+            if (format == Format::BC3)
+            {
+                decodeChannel(in, 3, pixels, stride);
+                decodeColor(in + 8, pixels, stride);
+            }
+            else
+            if (format == Format::BC5)
+            {
+                decodeChannel(in, 0, pixels, stride);
+                decodeChannel(in + 8, 1, pixels, stride);
+            }
+        }
+    return image.view(Rect<int>(size)).clone();
+}
+
+float psnr(const Image& image0, const Image& image1, Format format)
+{
+    const int channels = format == Format::BC1 ? 3 :
+                         format == Format::BC5 ? 2 : 4;
+    const auto size    = image0.size();
+
+    double error = 0.0;
+    for (int y = 0; y < size.h; ++y)
+    {
+        const uint8_t* r0 = image0.bits(0, y);
+        const uint8_t* r1 = image1.bits(0, y);
+        for (int x = 0; x < size.w; ++x)
+            for (int c = 0; c < channels; ++c)
+            {
+                const int d = r0[4 * x + c] - r1[4 * x + c];
+                error += d * d;
+            }
+    }
+    const double mse = error / (double(size.area()) * channels);
+    return mse > 0.0 ? float(10.0 * std::log10(255.0 * 255.0 / mse)) :
+                       std::numeric_limits<float>::infinity();
+}
+
+} // namespace BlockCodec
+} // namespace pt
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "img/image.h"
+
+namespace pt
+{
+namespace BlockCodec
+{
+
+// 4x4 block compression formats. None keeps pixels uncompressed.
+enum class Format
+{
+    None,
+    BC1, // RGB
+    BC3, // RGBA
+    BC5  // RG
+};
+
+// Bytes per 4x4 block
+int blockBytes(Format format);
+
+// Bytes of the blocks covering an image of a size
+std::size_t encodedSize(Format format, const Size<int>& size);
+
+// Encodes the blocks of an RGBA image row by row, replicating the last
+// column and row into partial blocks
+std::vector<uint8_t> encode(const Image& image, Format format);
+
+// Decodes blocks into an RGBA image. Channels a format lacks are 0,
+// alpha 255.
+Image decode(const uint8_t* blocks, Format format, const Size<int>& size);
+
+// Peak signal-to-noise ratio in dB over the channels a format stores
+float psnr(const Image& image0, const Image& image1, Format format);
+
+} // namespace BlockCodec
+} // namespace pt
@@ -1,6 +1,8 @@
 #include "image.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 
 #include <glm/glm.hpp>
 #include <glm/vec3.hpp>
@@ -17,31 +19,125 @@
 
 #include <nanovg.h>
 
+#ifdef PT_SPNG
+#include <spng.h>
+#endif
+
 #include "platform/clock.h"
 #include "common/log.h"
 
 #include "color.h"
+#include "image_kernels.h"
+#include "image_pool.h"
 
 namespace pt
 {
 
+namespace
+{
+
+// Reverses the row order in place
+void flipRows(uint8_t* bits, int height, int stride)
+{
+    for (int y = 0; y < height / 2; ++y)
+        std::swap_ranges(bits + y * stride, bits + (y + 1) * stride,
+                         bits + (height - y - 1) * stride);
+}
+
+#ifdef PT_SPNG
+// Decodes non-interlaced 8-bit PNGs with libspng, placing each row as it
+// is decoded. Returns null for formats left to stb_image.
+uint8_t* loadSpng(const fs::path& path, int depth, bool flipX,
+                  Size<int>& size)
+{
+    FILE* file = std::fopen(path.generic_string().c_str(), "rb");
+    if (!file)
+        return nullptr;
+
+    uint8_t*   bits = nullptr;
+    spng_ctx*  ctx  = spng_ctx_new(0);
+    spng_ihdr  ihdr;
+    spng_set_png_file(ctx, file);
+
+    if (!spng_get_ihdr(ctx, &ihdr) && !ihdr.interlace_method &&
+        ihdr.bit_depth <= 8)
+    {
+        const int fmt = depth == 4 ? SPNG_FMT_RGBA8 :
+                        depth == 3 ? SPNG_FMT_RGB8  :
+                        depth == 1 &&
+                        ihdr.color_type == SPNG_COLOR_TYPE_GRAYSCALE ?
+                                     SPNG_FMT_G8    : 0;
+
+        if (fmt && !spng_decode_image(ctx, nullptr, 0, fmt,
+                                      SPNG_DECODE_TRNS |
+                                      SPNG_DECODE_PROGRESSIVE))
+        {
+            const int w      = int(ihdr.width);
+            const int h      = int(ihdr.height);
+            const int stride = w * depth;
+            bits = static_cast<uint8_t*>(std::malloc(std::size_t(h) * stride));
+
+            // A failed allocation falls back to stb
+            int error = bits ? 0 : SPNG_EMEM;
+            spng_row_info info;
+            while (!error && !(error = spng_get_row_info(ctx, &info)))
+            {
+                const int y = flipX ? h - 1 - int(info.row_num) :
+                                      int(info.row_num);
+                if ((error = spng_decode_row(ctx, bits + y * stride,
+                                             std::size_t(stride))))
+                    break;
+            }
+
+            if (error == SPNG_EOI)
+                size = {w, h};
+            else
+            {
+                std::free(bits);
+                bits = nullptr;
+            }
+        }
+    }
+    spng_ctx_free(ctx);
+    std::fclose(file);
+    return bits;
+}
+#endif
+
+} // namespace
+
 struct Image::Data
 {
+    // Owner of the pixel memory
+    enum class Storage
+    {
+        None,
+        Pool,   // ImagePool buffer
+        Malloc, // Decoder buffer
+        View    // Region of another image's memory
+    };
+
     Size<int>    size;
     int          depth, stride;
     uint8_t*     bits;
+    Storage      storage;
     SDL_Surface* surface;
     NVGcontext*  nanoVg;
     int          nvgImage;
 
+    // Keeps the viewed memory alive
+    std::shared_ptr<const Data> owner;
+
     Data() :
         depth(0), stride(0),
-        bits(nullptr), surface(nullptr), nanoVg(nullptr), nvgImage(0)
+        bits(nullptr), storage(Storage::None),
+        surface(nullptr), nanoVg(nullptr), nvgImage(0)
     {}
 
     Data(const Size<int>& size, int depth, int stride) :
         size(size), depth(depth), stride(stride),
-        bits(new uint8_t[size.h * stride]),
+        bits(ImagePool::acquire(bytes())),
+        storage(Storage::Pool),
         surface(nullptr),
         nanoVg(nullptr),
         nvgImage(0)
@@ -52,7 +148,27 @@ struct Image::Data
         SDL_FreeSurface(surface);
         if (nanoVg)
             nvgDeleteImage(nanoVg, nvgImage);
-        delete bits;
+
+        if (storage == Storage::Pool)
+            ImagePool::release(bits, bytes());
+        else
+        if (storage == Storage::Malloc)
+            std::free(bits);
+    }
+
+    std::size_t bytes() const
+    {
+        return std::size_t(size.h) * stride;
+    }
+
+    std::size_t rowBytes() const
+    {
+        return std::size_t(size.w) * depth;
+    }
+
+    bool contiguous() const
+    {
+        return std::size_t(stride) == rowBytes();
     }
 };
 
@@ -71,15 +187,28 @@ Image::Image(const Size<int>& size, int depth, int stride) :
 {
 }
 
-Image::Image(const fs::path& path, int depth) :
+Image::Image(const fs::path& path, int depth, bool flipX) :
     d(std::make_shared<Data>())
 {
+#ifdef PT_SPNG
+    if ((d->bits = loadSpng(path, depth, flipX, d->size)))
+    {
+        d->storage = Data::Storage::Malloc;
+        d->depth   = depth;
+        d->stride  = d->size.w * d->depth;
+        return;
+    }
+#endif
     d->bits = stbi_load(path.generic_string().c_str(),
                         &d->size.w, &d->size.h, &d->depth, depth);
     if (depth > 0)
         d->depth = depth;
 
-    d->stride = d->size.w * d->depth;
+    d->storage = Data::Storage::Malloc;
+    d->stride  = d->size.w * d->depth;
+
+    if (flipX && d->bits)
+        flipRows(d->bits, d->size.h, d->stride);
 }
 
 Image::operator bool() const
@@ -87,6 +216,30 @@ Image::operator bool() const
     return d && d->size && d->bits;
 }
 
+Image Image::view(const Rect<int>& rect) const
+{
+    const int x0 = std::max(0, rect.x);
+    const int y0 = std::max(0, rect.y);
+    const int x1 = std::min(d->size.w, rect.x + rect.size.w);
+    const int y1 = std::min(d->size.h, rect.y + rect.size.h);
+    if (!*this || x1 <= x0 || y1 <= y0)
+        return Image();
+
+    Image image;
+    image.d->size    = {x1 - x0, y1 - y0};
+    image.d->depth   = d->depth;
+    image.d->stride  = d->stride;
+    image.d->bits    = d->bits + y0 * d->stride + x0 * d->depth;
+    image.d->storage = Data::Storage::View;
+    image.d->owner   = d->owner ? d->owner : d;
+    return image;
+}
+
+bool Image::contiguous() const
+{
+    return d->contiguous();
+}
+
 Size<int> Image::size() const
 {
     return d->size;
@@ -161,13 +314,18 @@ int Image::nvgImage(NVGcontext* nanoVg) const
     {
         d->nanoVg   = nanoVg;
         d->nvgImage = nvgCreateImageRGBA(
-                          nanoVg, d->size.w, d->size.h, 0, d->bits);
+                          nanoVg, d->size.w, d->size.h, 0,
+                          d->contiguous() ? d->bits : clone().bits());
     }
     return d->nvgImage;
 }
 
 Image Image::scaled(const Size<int>& size) const
 {
+    // Resampling at the same size reproduces the source
+    if (size == d->size)
+        return clone();
+
     Image image(size, d->depth);
     if(!stbir_resize_uint8(
            d->bits, d->size.w, d->size.h, d->stride,
@@ -190,25 +348,18 @@ Image Image::flipped(Axis axis) const
     if (axis == Axis::X)
     {
         // Flip vertically
+        const auto row = d->rowBytes();
         for (int y = 0; y < h; ++y)
-            std::copy(d->bits + y * stride,
-                      d->bits + y * stride + stride,
+            std::copy(d->bits + y * d->stride,
+                      d->bits + y * d->stride + row,
                       image.d->bits + (h - y - 1) * stride);
     }
     else
     {
         // Flip horizontally
-        if (d->depth == 1)
-            for (int y = 0; y < h; ++y)
-                for (int x = 0; x < w; ++x)
-                    *image.bits<uint8_t>(x, y) =
-                        *bits<const uint8_t>(w - x - 1, y);
-        else
-        if (d->depth == 4)
-            for (int y = 0; y < h; ++y)
-                for (int x = 0; x < w; ++x)
-                    *image.bits<uint32_t>(x, y) =
-                        *bits<const uint32_t>(w - x - 1, y);
+        if (d->depth == 1 || d->depth == 4)
+            ImageKernels::flipRows(d->bits, d->stride, w, h, d->depth,
+                                   image.d->bits, stride);
         else
             throw std::runtime_error("Not implemented for depth: " +
                                      std::to_string(d->depth));
@@ -218,16 +369,29 @@ Image Image::flipped(Axis axis) const
 
 Image Image::clone() const
 {
-    Image image(d->size, d->depth, d->stride);
-    std::copy(d->bits, d->bits + (d->size.h * d->stride), image.d->bits);
+    // Views are compacted into their own memory
+    Image image(d->size, d->depth);
+    const auto row = d->rowBytes();
+    if (d->contiguous())
+        std::copy(d->bits, d->bits + d->bytes(), image.d->bits);
+    else
+        for (int y = 0; y < d->size.h; ++y)
+            std::copy(d->bits + y * d->stride,
+                      d->bits + y * d->stride + row,
+                      image.d->bits + y * row);
     return image;
 }
 
 Image& Image::fill(uint32_t value)
 {
-    uint32_t* p0 = reinterpret_cast<uint32_t*>(d->bits);
-    uint32_t* p1 = reinterpret_cast<uint32_t*>(d->bits + d->size.h * d->stride);
-    std::fill(p0, p1, value);
+    const int rows  = d->contiguous() ? 1 : d->size.h;
+    const auto size = (d->contiguous() ? d->bytes() : d->rowBytes()) /
+                      sizeof(uint32_t);
+    for (int y = 0; y < rows; ++y)
+    {
+        uint32_t* p0 = reinterpret_cast<uint32_t*>(d->bits + y * d->stride);
+        std::fill(p0, p0 + size, value);
+    }
     return *this;
 }
 
@@ -236,29 +400,8 @@ Image Image::normals(float strenght) const
     if (d->depth == 1)
     {
         Image image(d->size, 4);
-        const int w = image.d->size.w;
-        const int h = image.d->size.h;
-
-        for (int y = 0; y < h; ++y)
-            for (int x = 0; x < w; ++x)
-            {
-                uint8_t tl = *bitsClamped(x - 1, y - 1);
-                uint8_t  t = *bitsClamped(x + 0, y - 1);
-                uint8_t tr = *bitsClamped(x + 1, y - 1);
-                uint8_t  l = *bitsClamped(x - 1, y + 0);
-                uint8_t  r = *bitsClamped(x + 1, y + 0);
-                uint8_t bl = *bitsClamped(x - 1, y + 1);
-                uint8_t  b = *bitsClamped(x + 0, y + 1);
-                uint8_t br = *bitsClamped(x + 1, y + 1);
-
-                float dx = (1.f / 255) * (tr + 2 * r + br - tl - 2 * l - bl);
-                float dy = (1.f / 255) * (bl + 2 * b + br - tl - 2 * t - tr);
-
-                glm::vec3  d(dx, dy, 1.f / strenght);
-                glm::uvec3 n(255.f * (0.5f * (glm::normalize(d) + 1.f)) + 0.5f);
-                *image.bits<uint32_t>(x, y) = argb(n);
-            }
-
+        ImageKernels::normals(d->bits, d->stride, d->size.w, d->size.h,
+                              strenght, image.d->bits, image.d->stride);
         return image;
     }
     return Image();
@@ -268,19 +411,8 @@ Image Image::maxToAlpha() const
 {
     Image image(d->size, 4);
     if (d->depth == 4)
-    {
-        const int w = image.d->size.w;
-        const int h = image.d->size.h;
-        for (int y = 0; y < h; ++y)
-            for (int x = 0; x < w; ++x)
-            {
-                auto argb0 = *bits<const uint32_t>(x, y);
-                auto  rgb0 = argbTuple(argb0).rgb();
-                auto    a1 = glm::compMax(rgb0);
-                auto argb1 = argb(glm::uvec4(rgb0, a1));
-                *image.bits<uint32_t>(x, y) = argb1;
-            }
-    }
+        ImageKernels::maxToAlpha(d->bits, d->stride, d->size.w, d->size.h,
+                                 image.d->bits, image.d->stride);
     else
         throw std::runtime_error("Not implemented for depth: " +
                                  std::to_string(d->depth));
@@ -296,9 +428,11 @@ bool Image::write(const fs::path& path) const
                                d->bits, d->stride);
     else
     if (ext == ".bmp")
-        return !stbi_write_bmp(path.generic_string().c_str(),
+        return d->contiguous() ?
+               !stbi_write_bmp(path.generic_string().c_str(),
                                d->size.w, d->size.h, d->depth,
-                               d->bits);
+                               d->bits) :
+               clone().write(path);
     return false;
 }
 
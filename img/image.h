@@ -6,6 +6,7 @@
 #include <SDL.h>
 
 #include "common/file_system.h"
+#include "geom/rect.h"
 #include "geom/size.h"
 
 struct NVGcontext;
@@ -24,10 +25,18 @@ struct Image
     Image();
     Image(const Size<int>& size, int depth);
     Image(const Size<int>& size, int depth, int stride);
-    Image(const fs::path& path,  int depth = 0);
+    // Rows are stored bottom-up when flipX, as by flipped(Axis::X)
+    Image(const fs::path& path,  int depth = 0, bool flipX = false);
 
     operator bool() const;
 
+    // Non-owning view of a region, sharing memory and stride. The viewed
+    // memory stays alive as long as the view.
+    Image view(const Rect<int>& rect) const;
+
+    // Rows are packed without padding
+    bool contiguous() const;
+
     Size<int> size() const;
 
     int depth() const;
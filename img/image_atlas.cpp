@@ -1,5 +1,10 @@
 #include "image_atlas.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+
 #include "platform/clock.h"
 #include "common/log.h"
 #include "painter.h"
@@ -10,116 +15,202 @@ namespace pt
 namespace
 {
 
-struct Node
+bool contains(const Rect<int>& a, const Rect<int>& b)
 {
-    typedef std::shared_ptr<Node> Ptr;
+    return b.x >= a.x && b.x + b.size.w <= a.x + a.size.w &&
+           b.y >= a.y && b.y + b.size.h <= a.y + a.size.h;
+}
 
-    Rect<int> rect;
-    Node::Ptr nodes[2];
-    bool reserved {};
+bool intersects(const Rect<int>& a, const Rect<int>& b)
+{
+    return a.x < b.x + b.size.w && b.x < a.x + a.size.w &&
+           a.y < b.y + b.size.h && b.y < a.y + a.size.h;
+}
 
-    Node()
-    {}
+// Appends the maximal rectangles of a free rectangle around a reserved one
+void split(const Rect<int>& f, const Rect<int>& used,
+           std::vector<Rect<int>>& pieces)
+{
+    const int ux1 = used.x + used.size.w;
+    const int uy1 = used.y + used.size.h;
+    const int fx1 = f.x + f.size.w;
+    const int fy1 = f.y + f.size.h;
 
-    Node(const Rect<int>& rect) : rect(rect)
-    {}
+    // Left, right, top, bottom
+    if (used.x > f.x)
+        pieces.emplace_back(f.x, f.y, used.x - f.x, f.size.h);
+    if (ux1 < fx1)
+        pieces.emplace_back(ux1, f.y, fx1 - ux1, f.size.h);
+    if (used.y > f.y)
+        pieces.emplace_back(f.x, f.y, f.size.w, used.y - f.y);
+    if (uy1 < fy1)
+        pieces.emplace_back(f.x, uy1, f.size.w, fy1 - uy1);
+}
 
-    bool isLeaf() const
+// Drops the rectangles contained by others, keeping one of equal ones
+void prune(std::vector<Rect<int>>& rects)
+{
+    std::vector<Rect<int>> kept;
+    for (std::size_t i = 0; i < rects.size(); ++i)
     {
-        return !nodes[0] && !nodes[1];
+        bool contained = false;
+        for (std::size_t j = 0; j < rects.size() && !contained; ++j)
+            contained = j != i && contains(rects[j], rects[i]) &&
+                        (j < i || !contains(rects[i], rects[j]));
+        if (!contained)
+            kept.push_back(rects[i]);
     }
+    rects.swap(kept);
+}
 
-    Node* reserve(const Size<int>& size)
-    {
-        if (isLeaf())
-        {
-            // Already contains data?
-            if (reserved)
-                return nullptr;
+// Maximal free rectangles keyed by width and then by height, so that
+// searches skip the rectangles too narrow in O(log n) and, within each
+// width wide enough, those too short in O(log n)
+struct FreeRects
+{
+    std::map<int, std::multimap<int, Rect<int>>> rects;
 
-            // Too small to fit?
-            if (rect.size.w < size.w || rect.size.h < size.h)
-                return nullptr;
+    void reset(const Size<int>& size)
+    {
+        rects.clear();
+        add(Rect<int>(size));
+    }
 
-            // Exact fit?
-            if (rect.size.w == size.w && rect.size.h == size.h)
-                return this;
+    void add(const Rect<int>& rect)
+    {
+        rects[rect.size.w].emplace(rect.size.h, rect);
+    }
 
-            // Create subnodes
-            nodes[0] = Node::Ptr(new Node());
-            nodes[1] = Node::Ptr(new Node());
+    std::vector<Rect<int>> all() const
+    {
+        std::vector<Rect<int>> all;
+        for (const auto& width : rects)
+            for (const auto& rect : width.second)
+                all.push_back(rect.second);
+        return all;
+    }
 
-            // Size deltas
-            const int dw = rect.size.w - size.w;
-            const int dh = rect.size.h - size.h;
+    // Best short side fit, placed at the top-left of the free rectangle.
+    // The shortest rectangle that fits scores the best of its width.
+    bool find(const Size<int>& size, Rect<int>& rect) const
+    {
+        int best = std::numeric_limits<int>::max();
+        for (auto it = rects.lower_bound(size.w);
+             it != rects.end() && best; ++it)
+        {
+            const auto fit = it->second.lower_bound(size.h);
+            if (fit == it->second.end())
+                continue;
 
-            // Determine split axis
-            if (dw > dh)
-            {
-                // Horizontal
-                nodes[0]->rect = Rect<int>(rect.x, rect.y,
-                                           size.w, rect.size.h);
-                nodes[1]->rect = Rect<int>(rect.x + size.w, rect.y,
-                                           rect.size.w - size.w, rect.size.h);
-            }
-            else
+            const auto& r = fit->second;
+            const int score = std::min(r.size.w - size.w, r.size.h - size.h);
+            if (score < best)
             {
-                // Vertical
-                nodes[0]->rect = Rect<int>(rect.x, rect.y,
-                                           rect.size.w, size.h);
-                nodes[1]->rect = Rect<int>(rect.x, rect.y + size.h,
-                                           rect.size.w, rect.size.h - size.h);
+                best = score;
+                rect = Rect<int>(r.x, r.y, size);
             }
-            // Reserve from first subnode
-            return nodes[0]->reserve(size);
-        }
-        else
-        {
-            // Try first subnode, then second
-            Node* node = nodes[0]->reserve(size);
-            return node ? node : nodes[1]->reserve(size);
         }
+        return best != std::numeric_limits<int>::max();
     }
 
-    bool release(const Rect<int>& rect)
+    // Erases the rectangles the predicate holds for
+    template <typename Pred>
+    void erase(Pred pred)
     {
-        if (isLeaf())
-        {
-            if (reserved && rect == this->rect)
-            {
-                reserved = false;
-                return true;
-            }
-        }
-        else
+        for (auto width = rects.begin(); width != rects.end();)
         {
-            // Release from subnodes
-            bool released = nodes[0]->release(rect);
-            return released || nodes[1]->release(rect);
+            auto& bucket = width->second;
+            for (auto it = bucket.begin(); it != bucket.end();)
+                it = pred(it->second) ? bucket.erase(it) : std::next(it);
+
+            width = bucket.empty() ? rects.erase(width) : std::next(width);
         }
+    }
+
+    bool contained(const Rect<int>& rect) const
+    {
+        for (const auto& width : rects)
+            for (const auto& r : width.second)
+                if (contains(r.second, rect))
+                    return true;
         return false;
     }
 
-    void draw(Painter* painter, uint32_t color) const
+    // Splits the free rectangles overlapping a reserved rectangle into
+    // the maximal rectangles around it
+    void reserve(const Rect<int>& used)
+    {
+        std::vector<Rect<int>> pieces;
+        erase([&](const Rect<int>& f)
+        {
+            if (!intersects(f, used))
+                return false;
+            split(f, used, pieces);
+            return true;
+        });
+
+        // Rectangles left untouched are maximal, so only the split ones
+        // can be contained by others
+        prune(pieces);
+        for (const auto& piece : pieces)
+            if (!contained(piece))
+                add(piece);
+    }
+
+    // Merges a released rectangle with the free space around it. Only the
+    // maximal rectangles overlapping it are new: they are split out of the
+    // atlas by the entries left, dropping the pieces that miss it, and
+    // replace the free rectangles they contain.
+    void release(const Rect<int>& released, const Size<int>& size,
+                 const std::vector<Rect<int>>& used)
     {
-        painter->setColor(color);
-        painter->drawRect(rect);
-        if (nodes[0]) nodes[0]->draw(painter, 0xff0000ff);
-        if (nodes[1]) nodes[1]->draw(painter, 0xffff0000);
+        std::vector<Rect<int>> merged = {Rect<int>(size)}, next;
+        for (const auto& u : used)
+        {
+            next.clear();
+            for (const auto& f : merged)
+                if (!intersects(f, u))
+                    next.push_back(f);
+                else
+                {
+                    const auto first = next.size();
+                    split(f, u, next);
+                    next.erase(std::remove_if(next.begin() + first,
+                                              next.end(),
+                                              [&](const Rect<int>& piece)
+                    {
+                        return !intersects(piece, released);
+                    }), next.end());
+                }
+            prune(next);
+            merged.swap(next);
+        }
+
+        erase([&](const Rect<int>& f)
+        {
+            for (const auto& m : merged)
+                if (contains(m, f))
+                    return true;
+            return false;
+        });
+        for (const auto& m : merged)
+            add(m);
     }
 };
 
-}
+} // namespace
 
 struct ImageAtlas::Data
 {
-    Image atlas;
-    Node  root;
+    Image                  atlas;
+    FreeRects              free;
+    std::vector<Rect<int>> used;
 
     Data(const Size<int>& size) :
-        atlas(size, 4), root(size)
+        atlas(size, 4)
     {
         atlas.fill(0xff000000);
+        free.reset(size);
     }
 };
 
@@ -140,25 +231,29 @@ Image ImageAtlas::image(bool drawNodes) const
     {
         atlas = atlas.clone();
         Painter painter(&atlas);
-        d->root.draw(&painter, 0xff0000ff);
+        painter.setColor(0xffff0000);
+        for (const auto& rect : d->free.all())
+            painter.drawRect(rect);
+        painter.setColor(0xff0000ff);
+        for (const auto& rect : d->used)
+            painter.drawRect(rect);
     }
     return atlas;
 }
 
 Rect<int> ImageAtlas::insert(const Image& image, int margin)
 {
-    if (image)
-        if (Node* node = d->root.reserve(image.size() + 2 * margin))
-        {
-            // Blit the image into atlas
-            Painter painter(&d->atlas);
-            painter.drawImageClamped(image, node->rect.x, node->rect.y, margin);
-
-            // Mark node reserved
-            node->reserved = true;
-            return node->rect;
-        }
+    Rect<int> rect;
+    if (image && d->free.find(image.size() + 2 * margin, rect))
+    {
+        // Blit the image into atlas
+        Painter painter(&d->atlas);
+        painter.drawImageClamped(image, rect.x, rect.y, margin);
 
+        d->free.reserve(rect);
+        d->used.push_back(rect);
+        return rect;
+    }
     return Rect<int>();
 }
 
@@ -175,8 +270,62 @@ RectCube<int> ImageAtlas::insert(const ImageCube& imageCube, int margin)
 
 ImageAtlas& ImageAtlas::remove(const Rect<int>& rect)
 {
-    d->root.release(rect);
+    const auto it = std::find(d->used.begin(), d->used.end(), rect);
+    if (it != d->used.end())
+    {
+        d->used.erase(it);
+        d->free.release(rect, size(), d->used);
+    }
     return *this;
 }
 
+ImageAtlas::Remap ImageAtlas::defragment()
+{
+    auto order = d->used;
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Rect<int>& a, const Rect<int>& b)
+    {
+        const int sa = std::max(a.size.w, a.size.h);
+        const int sb = std::max(b.size.w, b.size.h);
+        return sa != sb ? sa > sb : a.area() > b.area();
+    });
+
+    FreeRects free;
+    free.reset(size());
+
+    Remap remap;
+    for (const auto& rect : order)
+    {
+        Rect<int> packed;
+        if (!free.find(rect.size, packed))
+            return Remap();
+
+        free.reserve(packed);
+        remap.emplace_back(rect, packed);
+    }
+
+    // Move the pixels, margins included
+    const Image atlas = d->atlas.clone();
+    d->atlas.fill(0xff000000);
+    Painter painter(&d->atlas);
+    d->used.clear();
+    for (const auto& entry : remap)
+    {
+        painter.drawImage(atlas.view(entry.first),
+                          entry.second.x, entry.second.y);
+        d->used.push_back(entry.second);
+    }
+    d->free = std::move(free);
+    return remap;
+}
+
+float ImageAtlas::occupancy() const
+{
+    int area = 0;
+    for (const auto& rect : d->used)
+        area += rect.area();
+
+    return float(area) / std::max(1, size().area());
+}
+
 } // namespace pt
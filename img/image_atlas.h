@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "geom/rect.h"
@@ -10,8 +11,13 @@
 namespace pt
 {
 
+// MaxRects packer: free space is kept as the maximal free rectangles,
+// which overlap and merge on removal.
 struct ImageAtlas
 {
+    // Old and new rects of the entries repacked by defragment()
+    typedef std::vector<std::pair<Rect<int>, Rect<int>>> Remap;
+
     ImageAtlas(const Size<int>& size);
 
     Size<int> size() const;
@@ -22,6 +28,13 @@ struct ImageAtlas
 
     ImageAtlas& remove(const Rect<int>& rect);
 
+    // Repacks all entries largest first and moves their pixels. Returns
+    // an empty remap, leaving the atlas untouched, if they do not fit.
+    Remap defragment();
+
+    // Fraction of the atlas area reserved by entries
+    float occupancy() const;
+
 private:
     struct Data;
     std::shared_ptr<Data> d;
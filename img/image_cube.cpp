@@ -29,27 +29,36 @@ ImageCube::ImageCube(const fs::path& path, int depth, bool fallback)
         {"bottom", {}}
     };
 
-    // Load images
+    // Find the side files here, as filesystem errors must reach the caller
+    // rather than leave the parallel region
+    std::string filenames[6];
     for (int i = 0; i < 6; ++i)
     {
-        const auto side      = Side(i);
-        SideImage& sideImage = sideImages[i];
-
         const auto fn = boost::replace_all_copy(
-            path.generic_string(), "*", sideImage.name);
+            path.generic_string(), "*", sideImages[i].name);
 
         if (fs::exists(fn))
-        {
-            sideImage.image = side != Side::Top && side != Side::Bottom ?
-                              Image(fn, depth).flipped(Image::Axis::X) :
-                              Image(fn, depth);
-
-            const auto imageDepth = sideImage.image.depth();
-            if (sideImage.image.depth() != depth)
-                throw std::runtime_error("Unexpected depth: " +
-                                         std::to_string(imageDepth) +
-                                         " != " + std::to_string(depth));
-        }
+            filenames[i] = fn;
+    }
+
+    // Load images concurrently, flipping sides while decoding
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < 6; ++i)
+    {
+        const auto side = Side(i);
+        if (!filenames[i].empty())
+            sideImages[i].image = Image(filenames[i], depth,
+                                        side != Side::Top &&
+                                        side != Side::Bottom);
+    }
+
+    for (const auto& sideImage : sideImages)
+    {
+        const auto imageDepth = sideImage.image.depth();
+        if (sideImage.image && imageDepth != depth)
+            throw std::runtime_error("Unexpected depth: " +
+                                     std::to_string(imageDepth) +
+                                     " != " + std::to_string(depth));
     }
 
     // Mirror missing images with priority ordered fallbacks
@@ -62,8 +71,7 @@ ImageCube::ImageCube(const fs::path& path, int depth, bool fallback)
         {4, 2, 3, 0, 1}  // bottom
     };
 
-    // Find fallbacks
-    // TODO: Clone images
+    // Find fallbacks, sharing the memory of the mirrored images
     const Image imageDefault(Image(Size<int>(2, 2), depth).
                              fill(depth > 1 ? 0xff000000 : 0x00));
     if (fallback)
@@ -192,7 +200,7 @@ int ImageCube::merge(const ImageCube& cube)
     for (int i = 0; i < 6; ++i)
         if (const auto& side = cube.sides.at(i))
         {
-            sides[i] = side.clone();
+            sides[i] = side;
             ++mergeCount;
         }
 
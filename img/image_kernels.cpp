@@ -0,0 +1,292 @@
+#include "image_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PT_SSE2
+#endif
+
+#include "color.h"
+
+namespace pt
+{
+namespace ImageKernels
+{
+
+namespace
+{
+
+// Scalar normal of one pixel, the reference of the vector kernels
+inline uint32_t normal(const uint8_t* rt, const uint8_t* rc, const uint8_t* rb,
+                       int x, int w, float dz)
+{
+    const int x0 = std::max(x - 1, 0);
+    const int x1 = std::min(x + 1, w - 1);
+
+    const uint8_t tl = rt[x0], t = rt[x], tr = rt[x1];
+    const uint8_t  l = rc[x0],             r = rc[x1];
+    const uint8_t bl = rb[x0], b = rb[x], br = rb[x1];
+
+    const float dx = (1.f / 255) * (tr + 2 * r + br - tl - 2 * l - bl);
+    const float dy = (1.f / 255) * (bl + 2 * b + br - tl - 2 * t - tr);
+
+    const glm::vec3  d(dx, dy, dz);
+    const glm::uvec3 n(255.f * (0.5f * (glm::normalize(d) + 1.f)) + 0.5f);
+    return argb(n);
+}
+
+inline uint32_t maxToAlpha(uint32_t v)
+{
+    const uint32_t c = std::max(std::max(v & 0xff, (v >> 8) & 0xff),
+                                (v >> 16) & 0xff);
+    return (v & 0x00ffffff) | (c << 24);
+}
+
+#if defined(PT_AVX2)
+using Floats = __m256;
+using Ints   = __m256i;
+constexpr int LANES = 8;
+
+// Pixels x to x + LANES - 1 of a row, widened to 32 bits
+inline Ints load8(const uint8_t* p)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                                reinterpret_cast<const __m128i*>(p)));
+}
+
+inline Ints     add(Ints a, Ints b)        {return _mm256_add_epi32(a, b);}
+inline Ints     sub(Ints a, Ints b)        {return _mm256_sub_epi32(a, b);}
+inline Ints     shl(Ints a, int n)         {return _mm256_slli_epi32(a, n);}
+inline Ints     bor(Ints a, Ints b)        {return _mm256_or_si256(a, b);}
+inline Ints     seti(int v)                {return _mm256_set1_epi32(v);}
+inline Floats   setf(float v)              {return _mm256_set1_ps(v);}
+inline Floats   mul(Floats a, Floats b)    {return _mm256_mul_ps(a, b);}
+inline Floats   add(Floats a, Floats b)    {return _mm256_add_ps(a, b);}
+inline Floats   div(Floats a, Floats b)    {return _mm256_div_ps(a, b);}
+inline Floats   sqrt(Floats a)             {return _mm256_sqrt_ps(a);}
+inline Floats   toFloat(Ints a)            {return _mm256_cvtepi32_ps(a);}
+inline Ints     truncate(Floats a)         {return _mm256_cvttps_epi32(a);}
+inline void     store(uint8_t* p, Ints a)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+}
+#elif defined(PT_SSE2)
+using Floats = __m128;
+using Ints   = __m128i;
+constexpr int LANES = 4;
+
+inline Ints load8(const uint8_t* p)
+{
+    int32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    const auto zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero),
+                              zero);
+}
+
+inline Ints     add(Ints a, Ints b)        {return _mm_add_epi32(a, b);}
+inline Ints     sub(Ints a, Ints b)        {return _mm_sub_epi32(a, b);}
+inline Ints     shl(Ints a, int n)         {return _mm_slli_epi32(a, n);}
+inline Ints     bor(Ints a, Ints b)        {return _mm_or_si128(a, b);}
+inline Ints     seti(int v)                {return _mm_set1_epi32(v);}
+inline Floats   setf(float v)              {return _mm_set1_ps(v);}
+inline Floats   mul(Floats a, Floats b)    {return _mm_mul_ps(a, b);}
+inline Floats   add(Floats a, Floats b)    {return _mm_add_ps(a, b);}
+inline Floats   div(Floats a, Floats b)    {return _mm_div_ps(a, b);}
+inline Floats   sqrt(Floats a)             {return _mm_sqrt_ps(a);}
+inline Floats   toFloat(Ints a)            {return _mm_cvtepi32_ps(a);}
+inline Ints     truncate(Floats a)         {return _mm_cvttps_epi32(a);}
+inline void     store(uint8_t* p, Ints a)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+}
+#endif
+
+#if defined(PT_AVX2) || defined(PT_SSE2)
+// Normals of LANES interior pixels from x, with the operations of the
+// scalar reference in the same order
+inline Ints normals(const uint8_t* rt, const uint8_t* rc, const uint8_t* rb,
+                    int x, Floats dz)
+{
+    const Ints tl = load8(rt + x - 1), t = load8(rt + x), tr = load8(rt + x + 1);
+    const Ints  l = load8(rc + x - 1),                    r = load8(rc + x + 1);
+    const Ints bl = load8(rb + x - 1), b = load8(rb + x), br = load8(rb + x + 1);
+
+    const Ints ix = sub(sub(sub(add(add(tr, shl(r, 1)), br), tl), shl(l, 1)), bl);
+    const Ints iy = sub(sub(sub(add(add(bl, shl(b, 1)), br), tl), shl(t, 1)), tr);
+
+    const Floats k  = setf(1.f / 255);
+    const Floats dx = mul(k, toFloat(ix));
+    const Floats dy = mul(k, toFloat(iy));
+
+    // glm::normalize: d * (1 / sqrt((x * x + y * y) + z * z))
+    const Floats dot = add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+    const Floats inv = div(setf(1.f), sqrt(dot));
+
+    const auto channel = [&](Floats c)
+    {
+        const Floats n = mul(c, inv);
+        return truncate(add(mul(setf(255.f), mul(setf(0.5f), add(n, setf(1.f)))),
+                            setf(0.5f)));
+    };
+    return bor(bor(channel(dx), shl(channel(dy), 8)),
+               bor(shl(channel(dz), 16), seti(int(0xff000000))));
+}
+#endif
+
+} // namespace
+
+const char* vectorIsa()
+{
+#if defined(PT_AVX2)
+    return "AVX2";
+#elif defined(PT_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void normals(const uint8_t* src, int srcStride, int w, int h,
+             float strength, uint8_t* dst, int dstStride, Path path)
+{
+    const float dz = 1.f / strength;
+
+    for (int y = 0; y < h; ++y)
+    {
+        const uint8_t* rt = src + std::max(y - 1, 0)     * srcStride;
+        const uint8_t* rc = src + y                      * srcStride;
+        const uint8_t* rb = src + std::min(y + 1, h - 1) * srcStride;
+        uint32_t*      rd = reinterpret_cast<uint32_t*>(dst + y * dstStride);
+
+        int x = 0;
+#if defined(PT_AVX2) || defined(PT_SSE2)
+        if (path == Path::Vector && w > LANES + 1)
+        {
+            rd[0] = normal(rt, rc, rb, 0, w, dz);
+
+            // Interior pixels, reading up to x + LANES from x - 1
+            const Floats vdz = setf(dz);
+            for (x = 1; x + LANES < w; x += LANES)
+                store(reinterpret_cast<uint8_t*>(rd + x),
+                      normals(rt, rc, rb, x, vdz));
+        }
+#endif
+        for (; x < w; ++x)
+            rd[x] = normal(rt, rc, rb, x, w, dz);
+    }
+}
+
+void maxToAlpha(const uint8_t* src, int srcStride, int w, int h,
+                uint8_t* dst, int dstStride, Path path)
+{
+    for (int y = 0; y < h; ++y)
+    {
+        const auto* rs = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+        auto*       rd = reinterpret_cast<uint32_t*>(dst + y * dstStride);
+
+        int x = 0;
+#if defined(PT_AVX2)
+        if (path == Path::Vector)
+        {
+            const auto rgb = _mm256_set1_epi32(0x00ffffff);
+            for (; x + 8 <= w; x += 8)
+            {
+                const auto v = _mm256_and_si256(rgb, _mm256_loadu_si256(
+                               reinterpret_cast<const __m256i*>(rs + x)));
+                auto c = _mm256_max_epu8(v, _mm256_srli_epi32(v, 8));
+                c      = _mm256_max_epu8(c, _mm256_srli_epi32(v, 16));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rd + x),
+                    _mm256_or_si256(v, _mm256_slli_epi32(c, 24)));
+            }
+        }
+#elif defined(PT_SSE2)
+        if (path == Path::Vector)
+        {
+            const auto rgb = _mm_set1_epi32(0x00ffffff);
+            for (; x + 4 <= w; x += 4)
+            {
+                const auto v = _mm_and_si128(rgb, _mm_loadu_si128(
+                               reinterpret_cast<const __m128i*>(rs + x)));
+                auto c = _mm_max_epu8(v, _mm_srli_epi32(v, 8));
+                c      = _mm_max_epu8(c, _mm_srli_epi32(v, 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rd + x),
+                    _mm_or_si128(v, _mm_slli_epi32(c, 24)));
+            }
+        }
+#endif
+        for (; x < w; ++x)
+            rd[x] = maxToAlpha(rs[x]);
+    }
+}
+
+void flipRows(const uint8_t* src, int srcStride, int w, int h, int depth,
+              uint8_t* dst, int dstStride, Path path)
+{
+    for (int y = 0; y < h; ++y)
+    {
+        const uint8_t* rs = src + y * srcStride;
+        uint8_t*       rd = dst + y * dstStride;
+
+        // Destination bytes [x, x + 16) mirror source bytes
+        // [n - x - 16, n - x) of a row of n bytes
+        const int n = w * depth;
+        int x = 0;
+#if defined(PT_AVX2)
+        if (path == Path::Vector)
+        {
+            const auto bytes = _mm256_setr_epi8(
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            const auto words = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+            for (; x + 32 <= n; x += 32)
+            {
+                auto v = _mm256_loadu_si256(
+                         reinterpret_cast<const __m256i*>(rs + n - x - 32));
+                v = depth == 1 ?
+                    _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, bytes),
+                                             _MM_SHUFFLE(1, 0, 3, 2)) :
+                    _mm256_permutevar8x32_epi32(v, words);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rd + x), v);
+            }
+        }
+#elif defined(PT_SSE2)
+        if (path == Path::Vector)
+        {
+            for (; x + 16 <= n; x += 16)
+            {
+                auto v = _mm_loadu_si128(
+                         reinterpret_cast<const __m128i*>(rs + n - x - 16));
+                v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+                if (depth == 1)
+                {
+                    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rd + x), v);
+            }
+        }
+#endif
+        if (depth == 1)
+            for (; x < n; ++x)
+                rd[x] = rs[n - x - 1];
+        else
+        {
+            const auto* ps = reinterpret_cast<const uint32_t*>(rs);
+            auto*       pd = reinterpret_cast<uint32_t*>(rd);
+            for (x /= 4; x < w; ++x)
+                pd[x] = ps[w - x - 1];
+        }
+    }
+}
+
+} // namespace ImageKernels
+} // namespace pt
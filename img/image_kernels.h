@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pt
+{
+namespace ImageKernels
+{
+
+// Vectorized kernels compute the same bits as their scalar references
+enum class Path
+{
+    Scalar,
+    Vector
+};
+
+// Instruction set of the vector path: "AVX2", "SSE2" or "scalar"
+const char* vectorIsa();
+
+// Sobel normals of an 8-bit height image packed by argb(), edges clamped
+void normals(const uint8_t* src, int srcStride, int w, int h,
+             float strength, uint8_t* dst, int dstStride,
+             Path path = Path::Vector);
+
+// Replaces alpha with the maximum of R, G and B
+void maxToAlpha(const uint8_t* src, int srcStride, int w, int h,
+                uint8_t* dst, int dstStride, Path path = Path::Vector);
+
+// Mirrors each row of 1 or 4 byte pixels
+void flipRows(const uint8_t* src, int srcStride, int w, int h, int depth,
+              uint8_t* dst, int dstStride, Path path = Path::Vector);
+
+} // namespace ImageKernels
+} // namespace pt
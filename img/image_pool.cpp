@@ -0,0 +1,137 @@
+#include "image_pool.h"
+
+#include <array>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace pt
+{
+namespace ImagePool
+{
+
+namespace
+{
+
+// Size classes from 4 KiB to 1 GiB; larger buffers bypass the pool
+constexpr int         MIN_SHIFT   = 12;
+constexpr int         CLASS_COUNT = 19;
+// Released bytes kept for reuse before buffers are freed instead
+constexpr std::size_t MAX_POOLED  = std::size_t(64) << 20;
+
+struct Pool
+{
+    std::mutex                                     mutex;
+    std::array<std::vector<uint8_t*>, CLASS_COUNT> free;
+    std::size_t                                    bytes = 0;
+
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& buffers : free)
+        {
+            for (auto bits : buffers)
+                deallocate(bits);
+            buffers.clear();
+        }
+        bytes = 0;
+    }
+
+    static uint8_t* allocate(std::size_t size)
+    {
+        // Over-allocate and keep the offset to the block in front of the
+        // aligned pointer
+        auto block = static_cast<uint8_t*>(
+                     std::malloc(size + ALIGNMENT + sizeof(void*)));
+        if (!block)
+            throw std::bad_alloc();
+
+        auto bits = reinterpret_cast<uint8_t*>(
+                    (reinterpret_cast<std::uintptr_t>(block) + sizeof(void*) +
+                     ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+        reinterpret_cast<void**>(bits)[-1] = block;
+        return bits;
+    }
+
+    static void deallocate(uint8_t* bits)
+    {
+        std::free(reinterpret_cast<void**>(bits)[-1]);
+    }
+};
+
+// Never destroyed, so images released during static destruction find it
+Pool& pool()
+{
+    static Pool* pool = new Pool;
+    return *pool;
+}
+
+// Size class of a buffer size, or -1 if it is not pooled
+int sizeClass(std::size_t size)
+{
+    int shift = MIN_SHIFT;
+    while (shift < MIN_SHIFT + CLASS_COUNT && (std::size_t(1) << shift) < size)
+        ++shift;
+    return shift < MIN_SHIFT + CLASS_COUNT ? shift - MIN_SHIFT : -1;
+}
+
+} // namespace
+
+uint8_t* acquire(std::size_t size)
+{
+    const int c = sizeClass(size);
+    if (c < 0)
+        return Pool::allocate(size);
+
+    auto& p = pool();
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        auto& buffers = p.free[c];
+        if (!buffers.empty())
+        {
+            auto bits = buffers.back();
+            buffers.pop_back();
+            p.bytes  -= std::size_t(1) << (c + MIN_SHIFT);
+            return bits;
+        }
+    }
+    return Pool::allocate(std::size_t(1) << (c + MIN_SHIFT));
+}
+
+void release(uint8_t* bits, std::size_t size)
+{
+    if (!bits)
+        return;
+
+    const int c = sizeClass(size);
+    if (c >= 0)
+    {
+        const auto classSize = std::size_t(1) << (c + MIN_SHIFT);
+
+        auto& p = pool();
+        std::lock_guard<std::mutex> lock(p.mutex);
+        if (p.bytes + classSize <= MAX_POOLED)
+        {
+            p.free[c].push_back(bits);
+            p.bytes += classSize;
+            return;
+        }
+    }
+    Pool::deallocate(bits);
+}
+
+std::size_t pooledBytes()
+{
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    return p.bytes;
+}
+
+void trim()
+{
+    pool().trim();
+}
+
+} // namespace ImagePool
+} // namespace pt
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pt
+{
+namespace ImagePool
+{
+
+// Alignment of pooled buffers, enough for the widest vector kernels
+constexpr std::size_t ALIGNMENT = 64;
+
+// Returns an aligned buffer of at least size bytes. Buffers are rounded
+// up to power of two size classes and reused once released.
+uint8_t* acquire(std::size_t size);
+
+// Returns a buffer of the requested size to its size class
+void release(uint8_t* bits, std::size_t size);
+
+// Bytes held by released buffers awaiting reuse
+std::size_t pooledBytes();
+
+// Frees all released buffers
+void trim();
+
+} // namespace ImagePool
+} // namespace pt
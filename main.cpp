@@ -2,6 +2,7 @@
 
 #include "common/log.h"
 #include "application.h"
+#include "benchmark.h"
 
 int main(int argc, char** argv)
 {
@@ -10,11 +11,17 @@ int main(int argc, char** argv)
         using namespace boost::program_options;
         options_description desc("Allowed options");
         desc.add_options()
-            ("fullscreen,f", "Full screen mode");
+            ("fullscreen,f", "Full screen mode")
+            ("benchmark,b", value<std::string>(),
+             "Run a benchmark: animation, atlas, blocks, decode, framegraph,"
+             " image, mesher, simplifier, surfacenets, vertexcache");
 
         variables_map args;
         store(parse_command_line(argc, argv, desc), args);
 
+        if (args.count("benchmark"))
+            return pt::Benchmark().run(args) ? 0 : 1;
+
         pt::Application app;
         app.run(args);
     }
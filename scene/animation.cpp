@@ -1,5 +1,7 @@
 #include "animation.h"
 
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 
 #include <glm/gtc/type_ptr.hpp>
@@ -42,40 +44,8 @@ namespace pt
 {
 namespace
 {
-// Animation item type
-struct AnimationItem
-{
-    ozz::Animation*               anim;
-    ozz::SamplingCache*           cache;
-    ozz::Range<ozz::SoaTransform> locals;
-    ozz::Range<ozz::Float4x4>     models;
-
-    AnimationItem() : anim(nullptr), cache(nullptr)
-    {}
-
-    AnimationItem(ozz::Animation*               anim,
-                  ozz::SamplingCache*           cache,
-                  ozz::Range<ozz::SoaTransform> locals,
-                  ozz::Range<ozz::Float4x4>     models) :
-        anim(anim), cache(cache), locals(locals), models(models)
-    {}
-
-    ~AnimationItem()
-    {
-        if (anim)
-        {
-            auto allocator = ozz::memory::default_allocator();
-            allocator->Deallocate(locals);
-            allocator->Deallocate(models);
-            allocator->Delete(cache);
-            allocator->Delete(anim);
-        }
-    }
-};
-using AnimationItemPtr = std::unique_ptr<AnimationItem>;
-
-// Animations map
-using Animations = std::unordered_map<std::string, AnimationItemPtr>;
+// Clips by name
+using Clips = std::unordered_map<std::string, ozz::Animation*>;
 
 void setupJoints(ozz::RawSkeleton::Joint::Children& joints, const json& meta)
 {
@@ -113,9 +83,7 @@ void setupJoints(ozz::RawSkeleton::Joint::Children& joints, const json& meta)
     }
 }
 
-void setupAnimations(Animations& animations,
-                     ozz::Skeleton* skeleton,
-                     const fs::path& path, const json& meta)
+void setupAnimations(Clips& clips, const fs::path& path, const json& meta)
 {
     auto allocator = ozz::memory::default_allocator();
     for (const auto& nameValue : json::iterator_wrapper(meta))
@@ -153,15 +121,7 @@ void setupAnimations(Animations& animations,
         if (animation)
         {
             // Store by name
-            const auto jointCount    = skeleton->num_joints();
-            const auto soaJointCount = skeleton->num_soa_joints();
-            animations[name] = std::make_unique<AnimationItem>
-            (
-                animation,
-                allocator->New<ozz::SamplingCache>(jointCount),
-                allocator->AllocateRange<ozz::SoaTransform>(soaJointCount),
-                allocator->AllocateRange<ozz::Float4x4>(jointCount)
-            );
+            clips[name] = animation;
             #if 0
             PTLOG(Info) << name << ", '"
                         << animation->name() << "', "
@@ -216,12 +176,11 @@ ozz::Skeleton* createSkeleton(const fs::path& path, const json& meta)
     return skeleton;
 }
 
-Animations createAnimations(ozz::Skeleton* skeleton,
-                            const fs::path& path, const json& meta)
+Clips createClips(const fs::path& path, const json& meta)
 {
-    Animations animations;
-    setupAnimations(animations, skeleton, path, meta["animations"]);
-    return animations;
+    Clips clips;
+    setupAnimations(clips, path, meta["animations"]);
+    return clips;
 }
 
 } // namespace
@@ -230,25 +189,30 @@ struct Animation::Data
 {
     Data(const fs::path& path, const json& meta) :
         skeleton(createSkeleton(path, meta)),
-        animations(createAnimations(skeleton, path, meta)),
-        active(nullptr)
+        clips(createClips(path, meta))
     {}
 
     ~Data()
     {
         auto allocator = ozz::memory::default_allocator();
+        for (auto& clip : clips)
+            allocator->Delete(clip.second);
         allocator->Delete(skeleton);
     }
 
     ozz::Skeleton* skeleton;
-    Animations     animations;
-    AnimationItem* active;
+    Clips          clips;
 };
 
 Animation::Animation(const fs::path& path, const json& meta) :
     d(std::make_shared<Data>(path, meta))
 {}
 
+Animation::operator bool() const
+{
+    return d && d->skeleton;
+}
+
 int Animation::jointIndex(const std::string& name) const
 {
     const auto jointCount = d->skeleton->num_joints();
@@ -260,47 +224,119 @@ int Animation::jointIndex(const std::string& name) const
     return -1;
 }
 
-glm::mat4x4 Animation::jointMatrix(int index) const
+int Animation::jointCount() const
 {
-    if (d->active)
+    return d->skeleton->num_joints();
+}
+
+std::vector<std::string> Animation::clips() const
+{
+    std::vector<std::string> names;
+    for (const auto& clip : d->clips)
+        names.push_back(clip.first);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+struct AnimationPlayback::Data
+{
+    Data(const Animation& animation) :
+        animation(animation),
+        clip(nullptr),
+        phase(0.f)
     {
-        const auto& model = d->active->models[index];
+        auto allocator      = ozz::memory::default_allocator();
+        const auto skeleton = animation.d->skeleton;
+        cache  = allocator->New<ozz::SamplingCache>(skeleton->num_joints());
+        locals = allocator->AllocateRange<ozz::SoaTransform>(
+                     skeleton->num_soa_joints());
+        models = allocator->AllocateRange<ozz::Float4x4>(
+                     skeleton->num_joints());
+    }
+
+    ~Data()
+    {
+        auto allocator = ozz::memory::default_allocator();
+        allocator->Deallocate(locals);
+        allocator->Deallocate(models);
+        allocator->Delete(cache);
+    }
+
+    // Holds on to the shared skeleton and clips
+    Animation                     animation;
+    const ozz::Animation*         clip;
+    float                         phase;
+    ozz::SamplingCache*           cache;
+    ozz::Range<ozz::SoaTransform> locals;
+    ozz::Range<ozz::Float4x4>     models;
+};
+
+AnimationPlayback::AnimationPlayback(const Animation& animation) :
+    d(animation ? std::make_shared<Data>(animation) : nullptr)
+{}
+
+AnimationPlayback AnimationPlayback::clone() const
+{
+    AnimationPlayback playback;
+    if (d)
+    {
+        playback.d        = std::make_shared<Data>(d->animation);
+        playback.d->clip  = d->clip;
+        playback.d->phase = d->phase;
+    }
+    return playback;
+}
+
+glm::mat4x4 AnimationPlayback::jointMatrix(int index) const
+{
+    if (d && d->clip)
+    {
+        const auto& model = d->models[index];
         return glm::make_mat4(reinterpret_cast<const float*>(&model.cols[0]));
     }
     return {};
 }
 
-Animation& Animation::activate(const std::string& name)
+AnimationPlayback& AnimationPlayback::activate(const std::string& name,
+                                               Duration phase)
 {
-    for (auto& animation : d->animations)
-        if (animation.first == name)
-            d->active = animation.second.get();
-
+    if (d)
+    {
+        const auto& clips = d->animation.d->clips;
+        const auto it     = clips.find(name);
+        if (it != clips.end())
+        {
+            d->clip  = it->second;
+            d->phase = std::chrono::duration<float>(phase).count();
+            d->cache->Invalidate();
+        }
+    }
     return *this;
 }
 
-Animation& Animation::animate(TimePoint time, Duration /*step*/)
+AnimationPlayback& AnimationPlayback::animate(TimePoint time,
+                                              Duration /*step*/)
 {
-    if (d->active)
+    if (d && d->clip)
     {
         const auto t0 = std::chrono::duration<float>
-                       (time.time_since_epoch()).count();
+                       (time.time_since_epoch()).count() + d->phase;
 
         ozz::SamplingJob     sampJob;
         ozz::LocalToModelJob ltmJob;
 
-              auto item   = d->active;
-        const auto  a     = item->anim;
+        const auto a      = d->clip;
         const auto t1     = std::fmod(t0, a->duration());
         sampJob.animation = a;
-        sampJob.cache     = item->cache;
+        sampJob.cache     = d->cache;
         sampJob.time      = t1;
-        sampJob.output    = item->locals;
+        sampJob.output    = d->locals;
         sampJob.Run();
 
-        ltmJob.skeleton   = d->skeleton;
-        ltmJob.input      = item->locals;
-        ltmJob.output     = item->models;
+        ltmJob.skeleton   = d->animation.d->skeleton;
+        ltmJob.input      = d->locals;
+        ltmJob.output     = d->models;
         ltmJob.Run();
     }
     return *this;
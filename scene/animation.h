@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <glm/mat4x4.hpp>
 
@@ -12,15 +13,39 @@
 namespace pt
 {
 
+// Skeleton and clips, loaded once and shared by all playbacks. Immutable
+// after loading, so playbacks may sample it concurrently.
 struct Animation
 {
+    Animation() = default;
     Animation(const fs::path& path, const json& meta);
 
+    operator bool() const;
+
     int jointIndex(const std::string& name) const;
+    int jointCount() const;
+    std::vector<std::string> clips() const;
+
+private:
+    friend struct AnimationPlayback;
+    struct Data;
+    std::shared_ptr<const Data> d;
+};
+
+// Sampling state of an instance: active clip, phase, sampling cache and
+// joint buffers. Copies share the state, clones get their own.
+struct AnimationPlayback
+{
+    AnimationPlayback() = default;
+    explicit AnimationPlayback(const Animation& animation);
+
+    AnimationPlayback clone() const;
+
     glm::mat4x4 jointMatrix(int index) const;
 
-    Animation& activate(const std::string& name);
-    Animation& animate(TimePoint time, Duration step);
+    AnimationPlayback& activate(const std::string& name,
+                                Duration phase = Duration(0));
+    AnimationPlayback& animate(TimePoint time, Duration step);
 
 private:
     struct Data;
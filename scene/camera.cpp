@@ -95,4 +95,18 @@ float Camera::tanHalfFov() const
     return std::tan(0.5f * fov);
 }
 
+bool Camera::visible(const glm::vec3& center, float radius) const
+{
+    // Planes of the clip volume, normals pointing inward
+    const auto m = glm::transpose(matrix());
+    for (int i = 0; i < 6; ++i)
+    {
+        const auto plane = m[3] + (i % 2 ? -m[i / 2] : m[i / 2]);
+        const auto n     = glm::vec3(plane);
+        if (glm::dot(n, center) + plane.w < -radius * glm::length(n))
+            return false;
+    }
+    return true;
+}
+
 } // namespace pt
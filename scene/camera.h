@@ -27,6 +27,9 @@ struct Camera
 
     float tanHalfFov() const;
 
+    // Whether a sphere intersects the view frustum
+    bool visible(const glm::vec3& center, float radius) const;
+
     glm::vec4 infoClip() const;
     glm::vec4 infoProj() const;
 
@@ -61,8 +61,7 @@ namespace
 {
 
 Character::Parts readParts(const fs::path& path,
-                           ObjectStore& objectStore,
-                           TextureStore& textureStore)
+                           ObjectStore& objectStore)
 {
     Character::Parts parts;
     for (int i = 0; i < Character::PART_COUNT; ++i)
@@ -79,7 +78,7 @@ Character::Parts readParts(const fs::path& path,
         {-1, -1, -1, -1, -1, 6, 5, 8, 7, 10, 9, 12, 11, 14, 13, 16, 15, -1};
 
     for (int i = 0; i < Character::PART_COUNT; ++i)
-        if (!parts[i]) parts[i] = parts[fallbacks[i]].flipped(textureStore);
+        if (!parts[i]) parts[i] = parts[fallbacks[i]].flipped();
 
     return parts;
 }
@@ -122,22 +121,28 @@ struct Character::Data
 {
     Data(const fs::path& path,
          ObjectStore& objectStore,
-         TextureStore& textureStore) :
-        meta(objectStore.path() / path),
+         TextureStore& /*textureStore*/) :
+        Data(Meta(objectStore.path() / path), path, objectStore)
+    {}
+
+    Data(const Meta& meta, const fs::path& path, ObjectStore& objectStore) :
         anim(meta.animRoot, meta.meta),
+        playback(anim),
         boneMap(createBoneMap(anim)),
-        parts(readParts(path, objectStore, textureStore)),
+        parts(readParts(path, objectStore)),
         bones(createBones(parts))
     {
-        anim.activate("run_forward_inplace");
+        playback.activate("run_forward_inplace");
     }
 
-    Meta      meta;
-    Animation anim;
-    BoneMap   boneMap;
-    Parts     parts;
-    Bones     bones;
-    Object    volume;
+    // Shared by clones, apart from the playback and bones
+    Animation         anim;
+    AnimationPlayback playback;
+    BoneMap           boneMap;
+    Parts             parts;
+    Bones             bones;
+    Aabb              bounds;
+    Object            volume;
 };
 
 Character::Character(const Id& id,
@@ -149,6 +154,22 @@ Character::Character(const Id& id,
     updateVolume();
 }
 
+Character::operator bool() const
+{
+    return d.operator bool();
+}
+
+Character Character::clone() const
+{
+    Character character;
+    if (d)
+    {
+        character.d           = std::make_shared<Data>(*d);
+        character.d->playback = d->playback.clone();
+    }
+    return character;
+}
+
 const Character::Parts* Character::parts() const
 {
     return &d->parts;
@@ -159,6 +180,11 @@ const Character::Bones* Character::bones() const
     return &d->bones;
 }
 
+Aabb Character::bounds() const
+{
+    return d->bounds;
+}
+
 Object Character::volume() const
 {
     return d->volume;
@@ -178,24 +204,25 @@ Character& Character::updateVolume()
         max = glm::max(max, pos);
     }
     auto dim  = (max - min).xzy() / c::cell::SIZE;
+    d->bounds = Aabb(min, max);
     d->volume = Object(dim);
     return *this;
 }
 
-Character& Character::activate(const std::string& name)
+Character& Character::activate(const std::string& name, Duration phase)
 {
-    d->anim.activate(name);
+    d->playback.activate(name, phase);
     return *this;
 }
 
 Character& Character::animate(TimePoint time, Duration step)
 {
-    d->anim.animate(time, step);
+    d->playback.animate(time, step);
     for (int i = 0; i < PART_COUNT; ++i)
     {
         const auto boneIndex = d->boneMap[i];
         if (boneIndex >= 0)
-            d->bones[i].second = d->anim.jointMatrix(boneIndex);
+            d->bones[i].second = d->playback.jointMatrix(boneIndex);
     }
     return *this;
 }
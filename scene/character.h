@@ -6,6 +6,7 @@
 
 #include <glm/mat4x4.hpp>
 
+#include "geom/aabb.h"
 #include "platform/clock.h"
 #include "common/file_system.h"
 
@@ -54,13 +55,22 @@ struct Character
               ObjectStore& objectStore,
               TextureStore& textureStore);
 
+    operator bool() const;
+
+    // Instance sharing the skeleton, clips and parts, animated on its own
+    Character clone() const;
+
     const Parts* parts() const;
     const Bones* bones() const;
 
+    // Joint bounds at the last volume update, relative to the character
+    Aabb bounds() const;
+
     Object volume() const;
     Character& updateVolume();
 
-    Character& activate(const std::string& name);
+    Character& activate(const std::string& name,
+                        Duration phase = Duration(0));
     Character& animate(TimePoint time, Duration step);
 
 private:
@@ -14,6 +14,7 @@ using Density   = Grid<glm::vec4>;
 using Light     = Grid<glm::vec3>;
 using Indidence = Grid<glm::vec3>;
 using Emission  = Grid<glm::vec3>;
+using Occlusion = Grid<float>;
 using Pulse     = glm::vec2;
 
 } // namespace mat
@@ -1,18 +1,75 @@
 #include "model.h"
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/vec2.hpp>
 
 #include "common/log.h"
 #include "geom/image_mesher.h"
+#include "geom/mesh_deformer.h"
+#include "geom/mesh_optimizer.h"
 #include "img/image_cube.h"
 #include "gl/primitive.h"
+#include "constants.h"
 
 namespace pt
 {
 
+namespace
+{
+
+// Quantized mesh of a level of detail and its primitive
+struct Lod
+{
+    Lod() = default;
+
+    Lod(const Mesh_Packed& mesh, const glm::mat4& unpack) :
+        mesh(mesh), primitive(mesh, unpack)
+    {}
+
+    Lod(const Mesh_P_N_T_UV& mesh0, int layer)
+    {
+        glm::mat4 unpack;
+        mesh      = MeshOptimizer::quantize(mesh0, unpack, layer);
+        primitive = gl::Primitive(mesh, unpack);
+    }
+
+    Mesh_Packed   mesh;
+    gl::Primitive primitive;
+};
+
+// Levels of progressively decimated meshes, finest first
+std::vector<Lod> meshLods(const Occupancy& occupancy,
+                          const gl::TextureAtlas::EntryCube& atlasEntry,
+                          const geom::Meta& geom)
+{
+    const auto& uvCube = atlasEntry.uvs;
+    const auto layer   = std::max(0, atlasEntry.layer);
+    const auto size    = geom.scale * occupancy.size();
+    auto mesh          = ImageMesher::mesh(occupancy, uvCube, geom);
+    auto params        = geom::Simplify();
+    params.target      = c::model::LOD_TARGET;
+
+    std::vector<Lod> lods = {Lod(mesh, layer)};
+    for (int i = 1; i < c::model::LOD_COUNT && mesh.triangleCount(); ++i)
+    {
+        auto lod = MeshDeformer::decimate(mesh, uvCube, size, params);
+
+        // Stop once decimation no longer pays off
+        if (lod.triangleCount() > 3 * mesh.triangleCount() / 4)
+            break;
+
+        mesh = std::move(lod);
+        lods.emplace_back(mesh, layer);
+    }
+    return lods;
+}
+
+} // namespace
+
 struct Cubes
 {
     Cubes() = default;
@@ -62,25 +119,59 @@ struct Cubes
     ImageCube depth, albedo, light, normal;
 };
 
+namespace
+{
+
+// Atlas entry of the cubes, removed from the atlases with its last owner
+using SharedEntry = std::shared_ptr<const gl::TextureAtlas::EntryCube>;
+
+SharedEntry insertCubes(TextureStore& textureStore, const Cubes& cubes)
+{
+    auto* store = &textureStore;
+    auto  entry = textureStore.albedo.insert(cubes.albedo);
+                  textureStore.light.insert(cubes.light);
+                  textureStore.normal.insert(cubes.normal);
+
+    return SharedEntry(new gl::TextureAtlas::EntryCube(entry),
+        [store](const gl::TextureAtlas::EntryCube* entry)
+        {
+            if (gl::valid(*entry))
+            {
+                store->albedo.remove(*entry);
+                store->light.remove(*entry);
+                store->normal.remove(*entry);
+            }
+            delete entry;
+        });
+}
+
+} // namespace
+
 struct Model::Data
 {
     std::time_t lastUpdated;
     fs::path    path;
     geom::Meta  geom;
     Cubes       cubes;
+    Occupancy   occupancy;
 
-    gl::TextureAtlas::EntryCube atlasEntry;
-    gl::Primitive               primitive;
+    SharedEntry      atlasEntry;
+    std::vector<Lod> lods;
+    bool             mirror;
 
     Data(const fs::path& path, const Model& base,
          TextureStore& textureStore, const geom::Meta& geom) :
-         lastUpdated(0), path(path), geom(geom)
+         lastUpdated(0), path(path), geom(geom), mirror(false)
     {
         update(base, textureStore);
     }
 
     bool update(const Model& base, TextureStore& textureStore)
     {
+        // Mirrors keep the atlas entry they were mirrored from
+        if (mirror)
+            return false;
+
         const auto modified = std::max(base ? lastModified(base.d->path) : 0,
                                        lastModified(path));
         if (modified > lastUpdated)
@@ -93,23 +184,14 @@ struct Model::Data
             // Cube validation
             cubes.validate();
 
-            // Atlas removal
-            if (gl::valid(atlasEntry))
-            {
-                textureStore.albedo.remove(atlasEntry);
-                textureStore.light.remove(atlasEntry);
-                textureStore.normal.remove(atlasEntry);
-            }
-            // Atlas insert
-            atlasEntry  = textureStore.albedo.insert(cubes.albedo);
-                          textureStore.light.insert(cubes.light);
-                          textureStore.normal.insert(cubes.normal);
+            // Atlas removal, deferred while a mirror still samples the
+            // entry, and insert
+            atlasEntry.reset();
+            atlasEntry  = insertCubes(textureStore, cubes);
             // Update mesh
-            auto mesh   = ImageMesher::mesh(cubes.depth, atlasEntry.second, geom);
-            primitive   = gl::Primitive(mesh);
+            occupancy   = Occupancy(cubes.depth);
+            lods        = meshLods(occupancy, *atlasEntry, geom);
             lastUpdated = modified;
-
-            //PTLOG(Info) << path.string() << " tris: " << mesh.triangleCount();
             return true;
         }
         return false;
@@ -133,9 +215,14 @@ glm::vec3 Model::dimensions() const
     return d->geom.scale * glm::vec3(depth.width(), depth.height(), depth.depth());
 }
 
-gl::Primitive Model::primitive() const
+gl::Primitive Model::primitive(int lod) const
+{
+    return d->lods.at(std::min(lod, lodCount() - 1)).primitive;
+}
+
+int Model::lodCount() const
 {
-    return d->primitive;
+    return int(d->lods.size());
 }
 
 const ImageCube& Model::depthCube() const
@@ -153,12 +240,17 @@ const ImageCube& Model::lightCube() const
     return d->cubes.light;
 }
 
+const Occupancy& Model::occupancy() const
+{
+    return d->occupancy;
+}
+
 bool Model::update(const Model& base, TextureStore& textureStore)
 {
     return d->update(base, textureStore);
 }
 
-Model Model::flipped(TextureStore& textureStore) const
+Model Model::flipped() const
 {
     if (d)
     {
@@ -166,13 +258,20 @@ Model Model::flipped(TextureStore& textureStore) const
         auto model       = Model();
         model.d          = data;
         data->cubes      = d->cubes.flipped();
-        data->atlasEntry = textureStore.albedo.insert(data->cubes.albedo);
-                           textureStore.light.insert(data->cubes.light);
-                           textureStore.normal.insert(data->cubes.normal);
-        auto mesh        = ImageMesher::mesh(data->cubes.depth,
-                                             data->atlasEntry.second,
-                                             d->geom);
-        data->primitive  = gl::Primitive(mesh);
+        data->occupancy  = Occupancy(data->cubes.depth);
+        data->mirror     = true;
+
+        // Mirror the meshes instead of meshing the flipped cubes. The
+        // flipped images are the mirrored originals, so the atlas entry
+        // is shared. It outlives reloads of the source while the mirror
+        // holds it.
+        const auto width = dimensions().x;
+        for (auto& lod : data->lods)
+        {
+            auto unpack = lod.primitive.unpack;
+            auto mesh   = MeshOptimizer::mirrored(lod.mesh, unpack, width);
+            lod         = Lod(mesh, unpack);
+        }
         return model;
     }
     return Model();
@@ -7,6 +7,7 @@
 #include "common/file_system.h"
 #include "img/image.h"
 #include "geom/meta.h"
+#include "geom/occupancy.h"
 #include "gl/primitive.h"
 
 #include "texture_store.h"
@@ -26,15 +27,19 @@ struct Model
 
     glm::vec3 dimensions() const;
 
-    gl::Primitive primitive() const;
+    gl::Primitive primitive(int lod = 0) const;
+    int lodCount() const;
 
     const ImageCube& depthCube()  const;
     const ImageCube& albedoCube() const;
     const ImageCube& lightCube()  const;
 
+    const Occupancy& occupancy() const;
+
     bool update(const Model& base, TextureStore& textureStore);
 
-    Model flipped(TextureStore& textureStore) const;
+    // Mirror in X, sharing the atlas entry until both release it
+    Model flipped() const;
 
 private:
     struct Data;
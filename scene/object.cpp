@@ -1,10 +1,13 @@
 #include "object.h"
 
+#include <vector>
+#include <algorithm>
+
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/transform.hpp>
 
 #include "geom/meta.h"
-#include "geom/volume.h"
+#include "geom/occupancy.h"
 #include "img/color.h"
 
 #include "common/metadata.h"
@@ -18,11 +21,112 @@ namespace pt
 {
 namespace
 {
-using Projection = std::function<glm::vec3(const glm::vec3&)>;
+// Light-map projections, one per cube side
+template <ImageCube::Side S>
+struct Projection;
+
+template <>
+struct Projection<ImageCube::Side::Front>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x * v.x, pmax.y * v.z, pmax.z * v.y);}
+};
+
+template <>
+struct Projection<ImageCube::Side::Back>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x * v.x, pmax.y - pmax.y * v.z, pmax.z * v.y);}
+};
+
+template <>
+struct Projection<ImageCube::Side::Left>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x - pmax.x * v.z, pmax.y * v.x, pmax.z * v.y);}
+};
+
+template <>
+struct Projection<ImageCube::Side::Right>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x * v.z, pmax.y * v.x, pmax.z * v.y);}
+};
+
+template <>
+struct Projection<ImageCube::Side::Top>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x * v.x, pmax.y * v.y, pmax.z * v.z);}
+};
+
+template <>
+struct Projection<ImageCube::Side::Bottom>
+{
+    glm::vec3 operator()(const glm::vec3& pmax, const glm::vec3& v) const
+    {return glm::vec3(pmax.x * v.x, pmax.y * v.y, pmax.z * v.z);}
+};
+
+// Summary of the density updates a single side applies to a cell. Colors are
+// only blended once the cell alpha has turned negative, so the outcome is kept
+// for each sign of the incoming alpha and resolved when the sides are reduced.
+struct DensityAccum
+{
+    void add(const glm::vec3& rgb, float a1, float a)
+    {
+        if (count++)
+        {
+            rgbNeg  = 0.5f * (rgbNeg + rgb);
+            rgbLow  = 0.5f * (rgbLow + rgb);
+            rgbHigh = translucent ? 0.5f * (rgbHigh + rgb) : rgb;
+            scale  *= 0.5f;
+        }
+        else
+        {
+            rgbNeg  = 0.5f * rgb;
+            rgbLow  = rgb;
+            rgbHigh = rgb;
+            scale   = 0.5f;
+        }
+        translucent = translucent || a1 < 1.f;
+        alpha      *= a;
+    }
+
+    glm::vec4 apply(const glm::vec4& d0) const
+    {
+        if (!count)
+            return d0;
+
+        const auto a0  = d0.a;
+        const auto as  = a0 < 1.f || translucent ? -1.f : 1.f;
+        const auto rgb = a0 < 0.f ? scale * d0.rgb() + rgbNeg :
+                         a0 < 1.f ? rgbLow : rgbHigh;
+        return glm::vec4(rgb, as * std::abs(a0) * alpha);
+    }
+
+    glm::vec3 rgbNeg, rgbLow, rgbHigh;
+    float     scale       = 1.f;
+    float     alpha       = 1.f;
+    bool      translucent = false;
+    int       count       = 0;
+};
+
+// Material accumulated from a single cube side
+struct SideMaterial
+{
+    SideMaterial() = default;
+
+    SideMaterial(const glm::ivec3& size) :
+        emission(size), density(size)
+    {}
+
+    mat::Emission      emission;
+    Grid<DensityAccum> density;
+};
 
-void accumulateMaterial(mat::Emission& emission,
-                        mat::Density& density,
-                        const Projection& p,
+template <ImageCube::Side S>
+void accumulateMaterial(SideMaterial& material,
+                        const glm::vec3& pmax,
                         const Image& depth,
                         const Image& albedo,
                         const Image& light,
@@ -36,6 +140,21 @@ void accumulateMaterial(mat::Emission& emission,
     auto const sizeLight    = light.size();
     auto const scaleLight   = (sizeLight.as<glm::vec2>() /
                                sizeDepth.as<glm::vec2>()).x;
+    auto const alphaExp     = 0.75f * cellArea / area;
+    auto const sizeCell     = material.emission.size;
+    auto const maxCell      = sizeCell - 1;
+    const Projection<S> p;
+
+    // Depth columns and per-row work buffers
+    const int w = sizeLight.w;
+    std::vector<int>       cols(w), cells(w);
+    std::vector<float>     emis(w), alpha(w), opacity(w);
+    std::vector<glm::vec3> rgbs(w);
+    for (int x = 0; x < w; ++x)
+        cols[x] = int(x / float(w) * sizeDepth.w);
+
+    glm::vec3*    __restrict__ emission = material.emission.ptr();
+    DensityAccum* __restrict__ density  = material.density.ptr();
 
     for (int y = 0; y < sizeLight.h; ++y)
     {
@@ -50,32 +169,44 @@ void accumulateMaterial(mat::Emission& emission,
         const uint32_t* __restrict__ rowLight =
             reinterpret_cast<const uint32_t*>(light.bits(0, y));
 
-        for (int x = 0; x < sizeLight.w; ++x)
+        // Per-pixel terms, free of cross-iteration dependencies
+        #pragma omp simd
+        for (int x = 0; x < w; ++x)
         {
-            auto xd     = int(x / float(sizeLight.w) * sizeDepth.w);
-            auto d      = int(rowDepth[xd]);
-            auto out    = (p({x / float(sizeLight.w - 1),
-                              y / float(sizeLight.h - 1),
-                              d / 255}) + 0.5f) * objScale;
+            auto d      = int(rowDepth[cols[x]]);
+            auto out    = (p(pmax, {x / float(w - 1),
+                                    y / float(sizeLight.h - 1),
+                                    d / 255}) + 0.5f) * objScale;
+            auto cell   = glm::clamp(glm::ivec3(out),
+                                     glm::ivec3(0), maxCell);
+            cells[x]    = (cell.z * sizeCell.y + cell.y) * sizeCell.x + cell.x;
 
             auto albedo = argbTuple(rowAlbedo[x]);
             auto rgb    = glm::vec3(albedo.rgb());
-            auto rgbN   = glm::length(rgb) > 0.f ? glm::normalize(rgb) : rgb;
-            auto emis   = exp * argbTuple(rowLight[x]).b * rgbScale / scaleLight;
-
-            emission.at(out.x, out.y, out.z) += emis * rgbN;
-
-            auto& d0  = density.at(out.x, out.y, out.z);
-            auto  a0  = d0.a;
-            auto  a1  = albedo.a / 255.f;
-            auto  as  = std::min(a0, a1) < 1.f ? -1.f : 1.f;
-            auto  a   = std::abs(a0) * glm::pow(a1, 0.75f * cellArea / area);
-            auto rgb1 = a0 < 0.f ? 0.5f * (d0.rgb() + rgbN) : rgbN;
-            d0 = glm::vec4(rgb1, as * a);
+            auto len    = glm::length(rgb);
+            rgbs[x]     = len > 0.f ? rgb / len : rgb;
+            emis[x]     = exp * argbTuple(rowLight[x]).b * rgbScale / scaleLight;
+            opacity[x]  = albedo.a / 255.f;
+            alpha[x]    = glm::pow(opacity[x], alphaExp);
+        }
+
+        // Scatter into cells in pixel order
+        for (int x = 0; x < w; ++x)
+        {
+            const auto i = cells[x];
+            emission[i] += emis[x] * rgbs[x];
+            density[i].add(rgbs[x], opacity[x], alpha[x]);
         }
     }
 }
 
+using AccumulateMaterial = void (*)(SideMaterial&,
+                                    const glm::vec3&,
+                                    const Image&,
+                                    const Image&,
+                                    const Image&,
+                                    float, float);
+
 struct Meta
 {
     Meta() = default;
@@ -87,41 +218,8 @@ struct Meta
         const auto meta = readJson(path.first / c::object::METAFILE);
         if (!meta.is_null())
         {
-            base       = meta.value(c::object::meta::BASE, Object::Id());
-            geom.scale = meta.value(c::object::meta::SCALE, 1.f);
-            {
-                // Smooth deformer
-                const auto it = meta.find(c::object::meta::SMOOTH);
-                if (it != meta.end())
-                {
-                    const auto smooth = *it;
-                    if (smooth.is_number_integer())
-                        geom.smooth.iterations = smooth;
-                    else
-                    if (smooth.is_array())
-                    {
-                        geom.smooth.iterations = smooth[0];
-                        geom.smooth.strength   = smooth[1];
-                    }
-                }
-            }
-            {
-                // Simplify deformer
-                const auto it = meta.find(c::object::meta::SIMPLIFY);
-                if (it != meta.end())
-                {
-                    const auto simplify = *it;
-                    if (simplify.is_number_integer())
-                        geom.simplify.iterations = simplify;
-                    else
-                    if (simplify.is_array())
-                    {
-                        geom.simplify.iterations = simplify[0];
-                        geom.simplify.strength   = simplify[1];
-                        geom.simplify.scale      = simplify[2];
-                    }
-                }
-            }
+            base        = meta.value(c::object::meta::BASE, Object::Id());
+            geom        = geom::Meta::parse(meta);
             // Origin
             origin = geom.scale *
                      glm::make_vec3(meta.value(c::object::meta::ORIGIN,
@@ -330,35 +428,47 @@ Object& Object::updateDensity()
     const auto size = dimensions().xzy() / c::cell::SIZE.xzy();
 
     mat::Density map(glm::ceil(size));
-    const Cubefield cfield(d->model.depthCube());
+    const auto& occupancy = d->model.occupancy();
+
+    // Column spans of cells along X
+    std::vector<int> fx0(map.size.x), fx1(map.size.x), sums(map.size.x);
+    for (int x = 0; x < size.x; ++x)
+    {
+        fx0[x] = x * occupancy.width / size.x;
+        fx1[x] = (x + 1) * occupancy.width / size.x - 1;
+    }
 
+    std::vector<Occupancy::Word> columns(occupancy.stride);
     for (int z = 0; z < size.z; ++z)
         for (int y = 0; y < size.y; ++y)
+        {
+            int fy0 = y * occupancy.depth / size.y;
+            int fy1 = (y + 1) * occupancy.depth / size.y - 1;
+            int y0  = z * c::cell::SIZE.y;
+            int y1  = (z + 1) * c::cell::SIZE.y;
+
+            std::fill(sums.begin(), sums.end(), 0);
+            for (int fy = y0; fy < y1; ++fy)
+            {
+                // Columns occupied anywhere along the cell depth
+                std::fill(columns.begin(), columns.end(), 0);
+                for (int fz = fy0; fz <= fy1; ++fz)
+                    if (const auto row = occupancy.row(fy, fz))
+                        for (int i = 0; i < occupancy.stride; ++i)
+                            columns[i] |= row[i];
+
+                for (int x = 0; x < size.x; ++x)
+                    sums[x] += occupancy.count(columns.data(), fx0[x], fx1[x]);
+            }
+
             for (int x = 0; x < size.x; ++x)
             {
-                int fx0   = x * cfield.width / size.x;
-                int fy0   = y * cfield.depth / size.y;
-                int fx1   = (x + 1) * cfield.width / size.x - 1;
-                int fy1   = (y + 1) * cfield.depth / size.y - 1;
-                int width = fx1 - fx0 + 1;
-                int y0    = /*-d->meta.origin.y*/ + z * c::cell::SIZE.y;
-                int y1    = (z + 1) * c::cell::SIZE.y;
-
-                int sum = 0;
-                for (int fy = y0; fy < y1; ++fy)
-                    for (int fx = fx0; fx <= fx1; ++fx)
-                        for (int fz = fy0; fz <= fy1; ++fz)
-                            if (cfield(fx, fy, fz))
-                            {
-                                ++sum;
-                                break;
-                            }
-
-                float a = float(sum) / ((c::cell::SIZE.y /*+ d->meta.origin.y*/) *
-                                         width);
+                int   width = fx1[x] - fx0[x] + 1;
+                float a     = float(sums[x]) / (c::cell::SIZE.y * width);
 
                 map.at(x, y, z) = {1.f, 1.f, 1.f, a};
             }
+        }
 
     d->density = map;
     return *this;
@@ -399,30 +509,18 @@ Object& Object::updateMaterial()
     auto cubeAlbedo = d->model.albedoCube();
     auto cubeLight  = d->model.lightCube();
 
-    mat::Emission emission(glm::ceil(cellSize));
-    //PTLOG(Info) << name() << " size: " << emission.size.x << "x"
-    //                                   << emission.size.y << "x"
-    //                                   << emission.size.z;
-    const Projection projections[] =
+    const auto cellCount = glm::ivec3(glm::ceil(cellSize));
+    //PTLOG(Info) << name() << " size: " << cellCount.x << "x"
+    //                                   << cellCount.y << "x"
+    //                                   << cellCount.z;
+    const AccumulateMaterial accumulators[] =
     {
-        // Front
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x * v.x, pmax.y * v.z, pmax.z * v.y);},
-        // Back
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x * v.x, pmax.y - pmax.y * v.z, pmax.z * v.y);},
-        // Left
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x - pmax.x * v.z, pmax.y * v.x, pmax.z * v.y);},
-        // Right
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x * v.z, pmax.y * v.x, pmax.z * v.y);},
-        // Top
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x * v.x, pmax.y * v.y, pmax.z * v.z);},
-        // Bottom
-        [&pmax](const glm::vec3& v)
-        {return glm::vec3(pmax.x * v.x, pmax.y * v.y, pmax.z * v.z);}
+        &accumulateMaterial<ImageCube::Side::Front>,
+        &accumulateMaterial<ImageCube::Side::Back>,
+        &accumulateMaterial<ImageCube::Side::Left>,
+        &accumulateMaterial<ImageCube::Side::Right>,
+        &accumulateMaterial<ImageCube::Side::Top>,
+        &accumulateMaterial<ImageCube::Side::Bottom>
     };
     const float areas[] = {size.x * size.z,
                            size.x * size.z,
@@ -431,15 +529,31 @@ Object& Object::updateMaterial()
                            size.x * size.y,
                            size.x * size.y};
 
+    // Accumulate sides into separate grids
+    SideMaterial sides[6];
+    #pragma omp parallel for
     for (int i = 0; i < 6; ++i)
     {
         const auto side = ImageCube::Side(i);
-        accumulateMaterial(emission, d->density,
-                           projections[i], cubeDepth.side(side),
-                           cubeAlbedo.side(side),
-                           cubeLight.side(side),
-                           d->meta.geom.scale, areas[i]);
+        sides[i] = SideMaterial(cellCount);
+        accumulators[i](sides[i], pmax,
+                        cubeDepth.side(side),
+                        cubeAlbedo.side(side),
+                        cubeLight.side(side),
+                        d->meta.geom.scale, areas[i]);
     }
+
+    // Reduce in side order
+    mat::Emission emission(cellCount);
+    auto& density      = d->density;
+    const auto cellEnd = int(emission.data.size());
+    for (const auto& side : sides)
+        for (int i = 0; i < cellEnd; ++i)
+        {
+            emission.data[i] += side.emission.data[i];
+            density.data[i]   = side.density.data[i].apply(density.data[i]);
+        }
+
     d->emission = emission;
     return *this;
 }
@@ -466,7 +580,7 @@ bool Object::update(const Resolver& resolver, TextureStore& textureStore)
     return false;
 }
 
-Object Object::flipped(TextureStore& textureStore) const
+Object Object::flipped() const
 {
     if (d)
     {
@@ -476,7 +590,7 @@ Object Object::flipped(TextureStore& textureStore) const
 
         // Flip model
         if (d->model)
-            object.d->model = d->model.flipped(textureStore);
+            object.d->model = d->model.flipped();
 
         // Flip origin
         object.d->meta.origin.x = -d->meta.origin.x;
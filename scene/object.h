@@ -80,7 +80,7 @@ struct Object
 
     bool update(const Resolver& resolver, TextureStore& textureStore);
 
-    Object flipped(TextureStore& textureStore) const;
+    Object flipped() const;
 
     static Id   pathId(const Path& path);
     static bool exists(const fs::path& path);
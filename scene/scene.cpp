@@ -1,5 +1,6 @@
 #include "scene.h"
 
+#include <unordered_set>
 #include <vector>
 
 #include <glm/gtc/random.hpp>
@@ -34,6 +35,30 @@ struct Scene::Data
         horizon(Horizon::none())
     {}
 
+    // Movable objects at their state positions and characters, relative
+    // to the scene bounds
+    void addOccluders(const Aabb& aabb)
+    {
+        lightmapper.resetOccluders();
+        for (const auto& item : objectItems)
+        {
+            const auto& obj = item.obj;
+            if (obj.state().movable())
+            {
+                const auto m   = item.xform.matrix(obj.dimensions(),
+                                                   obj.origin());
+                const auto ms  = m * obj.state().xform();
+                const auto pos = item.xform.pos + glm::vec3(ms[3] - m[3]);
+                lightmapper.addOccluder(
+                    Transform(pos - aabb.min, item.xform.rot), obj);
+            }
+        }
+        for (const auto& item : charItems)
+            lightmapper.addOccluder(
+                Transform(item.xform.pos - aabb.min, item.xform.rot),
+                item.obj.volume());
+    }
+
     Horizon          horizon;
     ObjectItems      objectItems;
     CharacterItems   charItems;
@@ -195,8 +220,25 @@ Intersection Scene::intersect(const Ray& ray) const
     return {pos, items};
 }
 
-gfx::Geometry::Instances Scene::objectGeometry(GeometryType type) const
+gfx::Geometry::Instances Scene::objectGeometry(const Camera& camera,
+                                               GeometryType type) const
 {
+    // Level of detail from the projected radius of the item bounds
+    const auto eye     = camera.position();
+    const auto tanHalf = camera.tanHalfFov();
+    const auto lodOf   = [&](const glm::vec3& center, float radius)
+    {
+        const auto distance = glm::distance(eye, center);
+        if (distance <= radius)
+            return 0;
+
+        const auto size = radius / (distance * tanHalf);
+        int lod = 0;
+        while (lod < c::model::LOD_COUNT - 1 && size < c::model::LOD_SIZES[lod])
+            ++lod;
+        return lod;
+    };
+
     gfx::Geometry::Instances instances;
     instances.reserve(d->objectItems.size());
     for (const auto& item : d->objectItems)
@@ -207,10 +249,16 @@ gfx::Geometry::Instances Scene::objectGeometry(GeometryType type) const
 
         if (type == GeometryType::Any || gt == type)
         {
-            auto xform = item.xform.matrix(obj.dimensions(), obj.origin()) *
-                         obj.state().xform();
+            const auto dim = obj.dimensions();
+            auto xform     = item.xform.matrix(dim, obj.origin()) *
+                             obj.state().xform();
             if (const auto model = obj.model())
-                instances.emplace_back(model.primitive(), xform);
+            {
+                const auto center = glm::vec3(xform * glm::vec4(0.5f * dim, 1.f));
+                const auto lod    = lodOf(center, 0.5f * glm::length(dim));
+                const auto prim   = model.primitive(lod);
+                instances.emplace_back(prim, xform * prim.unpack);
+            }
         }
     }
     return instances;
@@ -232,7 +280,12 @@ gfx::Geometry::Instances Scene::characterGeometry() const
                 auto mj  = bone.second;
                 mj[3]   *= glm::vec4(glm::vec3(s), 1.f);
                 auto mo  = glm::translate(-hwh);
-                instances.emplace_back(obj.model().primitive(), mw * mj * mo);
+                auto mp  = mw * mj * mo;
+                auto prim = obj.model().primitive();
+
+                // Parts are lit at their center
+                instances.emplace_back(prim, mp * prim.unpack,
+                                       mp * glm::vec4(0.5f * dim, 1.f));
             }
 
     return instances;
@@ -254,33 +307,75 @@ Scene& Scene::updateLightmap()
                               << glm::to_string(cellResolution());
     #endif
 
-    // Objects
+    // Objects. Movable ones keep their emission and tint at their place,
+    // their opacity is an occluder.
     for (const auto& item : d->objectItems)
     {
         const auto& obj  = item.obj;
         const auto xform = Transform(item.xform.pos - aabb.min, item.xform.rot);
-        d->lightmapper.add(xform, obj);
-    }
-
-    // Characters
-    for (const auto& item : d->charItems)
-    {
-        const auto& obj  = item.obj.volume();
-        const auto xform = Transform(item.xform.pos - aabb.min, item.xform.rot);
-        d->lightmapper.add(xform, obj);
+        if (obj.state().movable())
+            d->lightmapper.addMovable(xform, obj);
+        else
+            d->lightmapper.add(xform, obj);
     }
+    d->addOccluders(aabb);
 
     d->lightmapper(d->horizon);
     return *this;
 }
 
-Scene& Scene::animate(TimePoint time, Duration step)
+Scene& Scene::animate(TimePoint time, Duration step, const Camera& camera)
 {
+    namespace ca = c::character::animation;
+
     for (auto& objItem : d->objectItems)
         objItem.obj.state().animate(time, step);
 
-    for (auto& charItem : d->charItems)
-        charItem.obj.animate(time, step);
+    // Steps between updates from the projected radius of the joint bounds
+    const auto eye     = camera.position();
+    const auto tanHalf = camera.tanHalfFov();
+    const auto stepsOf = [&](const glm::vec3& center, float radius)
+    {
+        if (!camera.visible(center, radius))
+            return ca::OFFSCREEN_STEPS;
+
+        const auto distance = glm::distance(eye, center);
+        if (distance <= radius)
+            return ca::LOD_STEPS[0];
+
+        const auto size = radius / (distance * tanHalf);
+        int lod = 0;
+        while (lod < ca::LOD_COUNT - 1 && size < ca::LOD_SIZES[lod])
+            ++lod;
+        return ca::LOD_STEPS[lod];
+    };
+
+    // Characters due in this step, staggered by index to spread the
+    // updates of slower rates over the steps. Copies share their playback
+    // and are animated once.
+    const auto frame = step.count() > 0 ? time.time_since_epoch() / step : 0;
+    std::vector<Character*> due;
+    std::unordered_set<const Character::Bones*> seen;
+    for (int i = 0; i < int(d->charItems.size()); ++i)
+    {
+        auto& item = d->charItems[i];
+        if (!seen.insert(item.obj.bones()).second)
+            continue;
+
+        const auto bounds = item.obj.bounds();
+        const auto center = item.xform.pos + bounds.center();
+        const auto radius = 0.5f * glm::length(bounds.size());
+        if ((frame + i) % stepsOf(center, radius) == 0)
+            due.push_back(&item.obj);
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < int(due.size()); ++i)
+        due[i]->animate(time, step);
+
+    // Re-bake around occluders that moved
+    d->addOccluders(bounds());
+    d->lightmapper.updateOccluders();
 
     return *this;
 }
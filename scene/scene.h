@@ -18,6 +18,7 @@
 #include "gfx/lightmap.h"
 #include "gl/texture.h"
 
+#include "camera.h"
 #include "horizon_store.h"
 #include "object_store.h"
 #include "scene_item.h"
@@ -56,6 +57,7 @@ struct Scene
     Intersection intersect(const Ray& ray) const;
 
     gfx::Geometry::Instances objectGeometry(
+        const Camera& camera,
         GeometryType type = GeometryType::Any) const;
 
     gfx::Geometry::Instances characterGeometry() const;
@@ -64,7 +66,9 @@ struct Scene
 
     Scene& updateLightmap();
 
-    Scene& animate(TimePoint time, Duration step);
+    // Animates objects, and characters in parallel at rates falling with
+    // their projected size
+    Scene& animate(TimePoint time, Duration step, const Camera& camera);
 
     bool write(const fs::path& path) const;
 
@@ -146,6 +146,11 @@ bool State::detach()
     return false;
 }
 
+bool State::movable() const
+{
+    return d->states.size() > 1;
+}
+
 glm::mat4x4 State::xform() const
 {
     return d->transition ? d->transition.xform :
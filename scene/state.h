@@ -19,6 +19,8 @@ struct State
     State clone() const;
     bool detach();
 
+    // Whether there are states to move between
+    bool movable() const;
     glm::mat4x4 xform() const;
 
     State& toggle(TimePoint time);
@@ -6,11 +6,18 @@ namespace pt
 {
 
 TextureStore::TextureStore(const Size<int>& size) :
-    albedo(size, true,  2),
-    light(size,  true,  2),
-    normal(size, false, 2)
+    albedo(size, true,  2, BlockCodec::Format::BC3),
+    light(size,  true,  2, BlockCodec::Format::BC3),
+    normal(size, false, 2, BlockCodec::Format::BC5)
 {
     PTLOG(Info) << "size: " << size.w << "x" << size.h;
 }
 
+void TextureStore::update()
+{
+    albedo.update();
+    light.update();
+    normal.update();
+}
+
 } // namespace pt
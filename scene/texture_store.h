@@ -11,6 +11,9 @@ struct TextureStore
 {
     TextureStore(const Size<int>& size);
 
+    // Uploads the atlas changes, once per frame
+    void update();
+
     gl::TextureAtlas albedo;
     gl::TextureAtlas light;
     gl::TextureAtlas normal;
@@ -5,10 +5,11 @@ const float PI = 3.14159265358979323846;
 
 // Uniforms
 uniform sampler2D tex;
-uniform mat4      v;
-uniform vec3      pos;
 uniform vec4      gridColor;
 
+// Per frame, shared by all programs
+#include "frame.glsl"
+
 // Input
 in Block
 {
@@ -41,7 +42,8 @@ vec4 sphere(vec3 p, sampler2D tex)
 void main(void)
 {
     vec3  ray = normalize(ib.viewRay) * mat3(v);
-    float gd  = gridDistance(pos, ray);
+    float gd  = gridDistance(viewPos, ray);
+    vec2  gp  = (viewPos + gd * ray).xz;
     color     = sphere(ray, tex) +
-                max(0, 1 - gd * 0.0015) * grid((pos + gd * ray).xz, gridColor);
+                max(0, 1 - gd * 0.0015) * grid(gp, gridColor);
 }
@@ -0,0 +1,19 @@
+#version 150
+
+// Unit vector from its octahedral encoding
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                        v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+// Bitangent sign and atlas layer packed in the normalized position w
+vec2 positionW(float w)
+{
+    float bits   = round(w * 65535.0);
+    float mirror = step(32768.0, bits);
+    return vec2(1.0 - 2.0 * mirror, bits - 32768.0 * mirror);
+}
@@ -0,0 +1,18 @@
+// Per frame constants in the std140 layout of gfx::FrameUniforms, whose
+// size is checked at link. Stages declare the block by including it.
+layout(std140) uniform Frame
+{
+    mat4  v;
+    mat4  p;
+    mat4  w;
+    mat3  n;
+    vec4  clip;
+    vec3  viewPos;
+    float tanHalfFov;
+    vec3  boundsMin;
+    float aspectRatio;
+    vec3  boundsSize;
+    float time;
+    float zNear;
+    float zFar;
+};
@@ -1,15 +1,16 @@
 #version 150
 
 // Uniforms
-uniform sampler2D texAlbedo;
-uniform sampler2D texNormal;
-uniform sampler2D texLight;
+uniform sampler2DArray texAlbedo;
+uniform sampler2DArray texNormal;
+uniform sampler2DArray texLight;
+uniform vec4           probe;
 
 // Input
 in Block
 {
     vec3 viewPos;
-    vec2 uv;
+    vec3 uv;
     vec3 bc;
     mat3 tbn;
 }
@@ -19,6 +20,7 @@ ib;
 out vec3 normal;
 out vec4 color;
 out vec4 light;
+out vec4 lightProbe;
 
 float edge(vec3 bc)
 {
@@ -29,10 +31,13 @@ float edge(vec3 bc)
 
 void main()
 {
-    vec4 alb = texture(texAlbedo, ib.uv);
-    vec3 n   = texture(texNormal, ib.uv).rgb;
-    normal   = normalize(ib.tbn * normalize(n * 2.0 - 1.0));
-    color    = alb;
-    //color    = vec4(mix(alb + 0.25, alb, edge(ib.bc)).rgb, 1.0);
-    light    = texture(texLight, ib.uv);
+    // Normal maps may store only XY, Z is positive
+    vec4 alb   = texture(texAlbedo, ib.uv);
+    vec2 nxy   = texture(texNormal, ib.uv).rg * 2.0 - 1.0;
+    vec3 n     = vec3(nxy, sqrt(max(1.0 - dot(nxy, nxy), 0.0)));
+    normal     = normalize(ib.tbn * n);
+    color      = alb;
+    //color      = vec4(mix(alb + 0.25, alb, edge(ib.bc)).rgb, 1.0);
+    light      = texture(texLight, ib.uv);
+    lightProbe = probe;
 }
@@ -2,34 +2,40 @@
 
 // Uniforms
 uniform mat4 m;
-uniform mat4 v;
-uniform mat4 p;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Input
-in vec3 position;
-in vec3 normal;
-in vec3 tangent;
+in vec4 position;
+in vec2 normal;
+in vec2 tangent;
 in vec2 uv;
 
 // Output
 out Block
 {
     vec3 viewPos;
-    vec2 uv;
+    vec3 uv;
     vec3 bc;
     mat3 tbn;
 }
 ob;
 
+// Externals
+vec3 octDecode(vec2 e);
+vec2 positionW(float w);
+
 void main()
 {
     mat4 mv      = v * m;
-    vec3 t       = normalize(mat3(mv) * tangent);
-    vec3 n       = normalize(mat3(mv) * normal);
-    vec3 b       = normalize(cross(t, n));
-    vec4 viewPos = mv * vec4(position, 1.0);
+    vec2 w       = positionW(position.w);
+    vec3 t       = normalize(mat3(mv) * octDecode(tangent));
+    vec3 n       = normalize(mat3(mv) * octDecode(normal));
+    vec3 b       = normalize(cross(t, n)) * w.x;
+    vec4 viewPos = mv * vec4(position.xyz, 1.0);
     ob.viewPos   = viewPos.xyz;
-    ob.uv        = uv;
+    ob.uv        = vec3(uv, w.y);
     ob.bc        = vec3(1);
     ob.tbn       = mat3(t, b, n);
     gl_Position  = p * viewPos;
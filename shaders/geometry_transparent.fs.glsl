@@ -1,13 +1,13 @@
 #version 150
 
 // Uniforms
-uniform sampler2D texAlbedo;
-uniform sampler2D texLight;
-uniform sampler3D texGi;
-uniform sampler3D texIncid;
-uniform vec3      boundsMin;
-uniform vec3      boundsSize;
-uniform vec3      viewPos;
+uniform sampler2DArray texAlbedo;
+uniform sampler2DArray texLight;
+uniform sampler3D      texGi;
+uniform sampler3D      texIncid;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Const
 vec3 sizeTexGi = textureSize(texGi, 0);
@@ -17,7 +17,7 @@ in Block
 {
     vec3 worldPos;
     vec3 normal;
-    vec2 uv;
+    vec3 uv;
 }
 ib;
 
@@ -2,13 +2,14 @@
 
 // Uniforms
 uniform mat4 m;
-uniform mat4 v;
-uniform mat4 p;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Input
-in vec3 position;
-in vec3 normal;
-in vec3 tangent;
+in vec4 position;
+in vec2 normal;
+in vec2 tangent;
 in vec2 uv;
 
 // Output
@@ -16,16 +17,20 @@ out Block
 {
     vec3 worldPos;
     vec3 normal;
-    vec2 uv;
+    vec3 uv;
 }
 ob;
 
+// Externals
+vec3 octDecode(vec2 e);
+vec2 positionW(float w);
+
 void main()
 {
-    vec4 pos       = vec4(position, 1.0);
+    vec4 pos       = vec4(position.xyz, 1.0);
     mat3 normalMat = transpose(inverse(mat3(m)));
     ob.worldPos    = vec3(m * pos);
-    ob.normal      = normalMat * normal;
-    ob.uv          = uv;
+    ob.normal      = normalize(normalMat * octDecode(normal));
+    ob.uv          = vec3(uv, positionW(position.w).y);
     gl_Position    = p * v * m * pos;
 }
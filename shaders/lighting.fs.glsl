@@ -5,15 +5,14 @@ uniform sampler2D texDepth;
 uniform sampler2D texNormal;
 uniform sampler2D texColor;
 uniform sampler2D texLight;
+uniform sampler2D texProbe;
 uniform sampler2D texAo;
 uniform sampler2D texSc;
 uniform sampler3D texGi;
 uniform sampler3D texIncid;
-uniform mat4      w;
-uniform mat3      n;
-uniform vec3      boundsMin;
-uniform vec3      boundsSize;
-uniform float     time;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Input
 in Block
@@ -33,8 +32,11 @@ vec3 worldUvw(vec3 pos, vec3 boundsMin, vec3 boundsMax);
 
 void main(void)
 {
+    // Instances with a light probe are lit at the probe
     vec3 worldPos   = world(texDepth, ib.uv, w);
-    vec3 uvwGi      = worldUvw(worldPos, boundsMin, boundsSize);
+    vec4 probe      = texture(texProbe, ib.uv);
+    vec3 giPos      = mix(worldPos, probe.xyz, probe.w);
+    vec3 uvwGi      = worldUvw(giPos, boundsMin, boundsSize);
     vec4 gi         = texture(texGi, uvwGi);
 
     vec3 ao         = texture(texAo, ib.uv).r * gi.rgb;
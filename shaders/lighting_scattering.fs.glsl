@@ -3,12 +3,11 @@
 // Uniforms
 uniform sampler2D texDepth;
 uniform sampler3D texGi;
-uniform mat4      w;
-uniform vec3      camPos;
-uniform vec3      boundsMin;
-uniform vec3      boundsSize;
 uniform int       sampleCount;
 
+// Per frame, shared by all programs
+#include "frame.glsl"
+
 // Const
 const float SCATTER_DIST = 100.0;
 
@@ -29,7 +28,7 @@ vec3 worldUvw(vec3 pos, vec3 boundsMin, vec3 boundsMax);
 
 vec3 scattering(vec3 start)
 {
-    vec3 ray  = normalize(camPos - start);
+    vec3 ray  = normalize(viewPos - start);
     vec3 end  = start + ray * SCATTER_DIST;
     vec3 uvw0 = worldUvw(start, boundsMin, boundsSize);
     vec3 uvw1 = worldUvw(end, boundsMin, boundsSize);
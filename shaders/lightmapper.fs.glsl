@@ -3,6 +3,7 @@
 // Uniforms
 uniform sampler3D      density;
 uniform sampler3D      emission;
+uniform sampler3D      occlusion;
 uniform sampler2D      horizon;
 uniform isamplerBuffer lightSrc;
 
@@ -31,7 +32,8 @@ out vec4 light;
 out vec4 incidence;
 
 // Externals
-float vis(sampler3D tex, ivec3 p0, ivec3 p1, inout vec3 e, float el);
+float vis(sampler3D tex, sampler3D occ, ivec3 p0, ivec3 p1,
+          inout vec3 e, float el);
 float cmin(vec3 v);
 float cmax(vec3 v);
 
@@ -68,7 +70,7 @@ void main(void)
             {
                 vec3  e = texelFetch(emission, p1, 0).rgb;
                 float s = length(e);
-                float v = vis(density, p1, p0, e, s);
+                float v = vis(density, occlusion, p1, p0, e, s);
                 if (v > 0.0)
                 {
                     float a = v * v * att;
@@ -117,7 +119,7 @@ void main(void)
         if (h.a > 0.0)
         {
             vec3 e  = h.rgb;
-            float v = vis(density, p1, p0, e, length(e));
+            float v = vis(density, occlusion, p1, p0, e, length(e));
             if (v > 0.0)
             {
                 l += weight * v * e;
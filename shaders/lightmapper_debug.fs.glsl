@@ -3,12 +3,11 @@
 // Uniforms
 uniform sampler2D texDepth;
 uniform sampler3D texDensity;
-uniform mat4      w;
-uniform vec3      camPos;
-uniform vec3      boundsMin;
-uniform vec3      boundsSize;
 uniform int       sampleCount;
 
+// Per frame, shared by all programs
+#include "frame.glsl"
+
 // Input
 in Block
 {
@@ -26,9 +25,9 @@ vec3 worldUvw(vec3 pos, vec3 boundsMin, vec3 boundsMax);
 
 vec3 density(vec3 start)
 {
-    vec3 ray  = normalize(camPos - start);
-    vec3 end  = camPos - 1000.0 * ray;
-    vec3 uvw0 = worldUvw(camPos, boundsMin, boundsSize);
+    vec3 ray  = normalize(viewPos - start);
+    vec3 end  = viewPos - 1000.0 * ray;
+    vec3 uvw0 = worldUvw(viewPos, boundsMin, boundsSize);
     vec3 uvw1 = worldUvw(end,    boundsMin, boundsSize);
     vec3 uvws = (uvw1 - uvw0) / sampleCount;
 
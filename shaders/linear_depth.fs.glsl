@@ -2,7 +2,9 @@
 
 // Uniforms
 uniform sampler2D tex;
-uniform vec4      clip;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Input
 in Block
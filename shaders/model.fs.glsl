@@ -1,13 +1,13 @@
 #version 150
 
 // Uniforms
-uniform sampler2D texAlbedo;
+uniform sampler2DArray texAlbedo;
 
 // Input
 in Block
 {
     vec3 normal;
-    vec2 uv;
+    vec3 uv;
 }
 ib;
 
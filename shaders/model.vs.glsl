@@ -4,22 +4,26 @@
 uniform mat4 mvp;
 
 // Input
-in vec3 position;
-in vec3 normal;
-in vec3 tangent;
+in vec4 position;
+in vec2 normal;
+in vec2 tangent;
 in vec2 uv;
 
 // Output
 out Block
 {
     vec3 normal;
-    vec2 uv;
+    vec3 uv;
 }
 ob;
 
+// Externals
+vec3 octDecode(vec2 e);
+vec2 positionW(float w);
+
 void main()
 {
-    ob.normal   = normal;
-    ob.uv       = uv;
-    gl_Position = mvp * vec4(position, 1.0);
+    ob.normal   = octDecode(normal);
+    ob.uv       = vec3(uv, positionW(position.w).y);
+    gl_Position = mvp * vec4(position.xyz, 1.0);
 }
@@ -1,10 +1,11 @@
 #version 150
 
 // Uniforms
-uniform float tanHalfFov;
-uniform float aspectRatio;
 uniform float z;
 
+// Per frame, shared by all programs
+#include "frame.glsl"
+
 // Input
 in vec3 position;
 in vec2 uv;
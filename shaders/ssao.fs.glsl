@@ -11,7 +11,9 @@ uniform sampler2D texNoise;
 uniform int       kernelSize;
 uniform vec3      kernel[KERNEL_SIZE_MAX];
 uniform vec2      noiseScale;
-uniform mat4      p;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Input
 in Block
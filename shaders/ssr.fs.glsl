@@ -7,11 +7,10 @@
 // Uniforms
 uniform sampler2D texDepth;
 uniform sampler2D texNormal;
-uniform mat4      v;
-uniform mat4      p;
 uniform mat4      pc;
-uniform float     zNear;
-uniform float     zFar;
+
+// Per frame, shared by all programs
+#include "frame.glsl"
 
 // Const
 vec2 sizeTex = textureSize(texDepth, 0);
@@ -1,6 +1,8 @@
 #version 150
 
-float vis(sampler3D tex, ivec3 p0, ivec3 p1, inout vec3 e, float el)
+// Visibility through the static density and the occlusion of dynamic items
+float vis(sampler3D tex, sampler3D occ, ivec3 p0, ivec3 p1,
+          inout vec3 e, float el)
 {
     // Make results symmetrical between endpoints
     if (p0.y > p1.y || p0.z > p1.z)
@@ -22,12 +24,13 @@ float vis(sampler3D tex, ivec3 p0, ivec3 p1, inout vec3 e, float el)
         vec4 d  = texelFetch(tex, ivec3(p), 0);
         float a = abs(d.a);
         e = d.a < 0 ? mix(e, el * d.rgb, min(1.0, 1.0 - a)) : e;
-        v -= a;
+        v -= a + texelFetch(occ, ivec3(p), 0).r;
     }
     return max(0.0, v);
 }
 
-float visSym(sampler3D tex, vec3 p0, vec3 p1, inout vec3 e, float el)
+float visSym(sampler3D tex, sampler3D occ, vec3 p0, vec3 p1,
+             inout vec3 e, float el)
 {
     p0 += 0.5; p1 += 0.5;
 
@@ -52,7 +55,7 @@ float visSym(sampler3D tex, vec3 p0, vec3 p1, inout vec3 e, float el)
             vec4 d  = texelFetch(tex, ivec3(p), 0);
             float a = abs(d.a);
             e = d.a < 0 ? mix(e, el * d.rgb, min(1.0, 1.0 - a)) : e;
-            v -= a;
+            v -= a + texelFetch(occ, ivec3(p), 0).r;
         }
 
         bvec3 lt  = lessThan(m.xxy, m.yzz);
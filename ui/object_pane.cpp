@@ -13,6 +13,7 @@
 #include <nanogui/vscrollpanel.h>
 
 #include "platform/display.h"
+#include "gl/state.h"
 #include "gl/texture_atlas.h"
 #include "geom/image_mesher.h"
 #include "common/log.h"
@@ -50,6 +51,9 @@ struct ObjectPane::Data
 
         gfx::Preview preview(previewSize);
 
+        // Previews sample the atlas before the first frame uploads it
+        textureStore->update();
+
         ng::ImagePanel::Images nvgImages;
         for (const auto& object : objectStore->objects())
             if (!object.parent())
@@ -63,6 +67,9 @@ struct ObjectPane::Data
 
                 auto nvgImage = image.nvgImage(display->nanoVg());
                 nvgImages.push_back({nvgImage, object.name()});
+
+                // NanoVG uploads the image behind the GL state cache
+                gl::State::reset();
             }
 
         auto& vscroll = widget->add<ng::VScrollPanel>();
@@ -47,7 +47,18 @@ void RenderStats::accumulate(const Time& frameTime)
     }
 }
 
-RenderStats& RenderStats::operator()(float fps, const glm::ivec3& sceneSize)
+void RenderStats::accumulate(const std::string& name, Duration duration)
+{
+    using Milli = std::chrono::duration<float, std::milli>;
+    auto it = d->times.find(name);
+    if (it != d->times.end())
+        it->second.push(Milli(duration).count());
+    else
+        d->times.insert({name, MovingAvg<float>(MOVING_AVG_LEN)});
+}
+
+RenderStats& RenderStats::operator()(float fps, const glm::ivec3& sceneSize,
+                                     const gl::Counts& glCounts)
 {
     GLint viewport[4];
     glGetIntegerv(GL_VIEWPORT, viewport);
@@ -65,6 +76,12 @@ RenderStats& RenderStats::operator()(float fps, const glm::ivec3& sceneSize)
                                << sceneSize.x << "x"
                                << sceneSize.y << "x"
                                << sceneSize.z).c_str(), 0);
+    nvgText(d->vg, 340, 20, str(std::stringstream()
+                               << "GL: "
+                               << glCounts.calls    << " calls, "
+                               << glCounts.skipped  << " skipped, "
+                               << glCounts.draws    << " draws, "
+                               << glCounts.uniforms << " uniforms").c_str(), 0);
 
     std::vector<std::pair<std::string, float>> times;
     for (const auto& t : d->times)
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include <glm/vec3.hpp>
 
 #include "platform/clock.h"
 #include "common/statistics.h"
 #include "gl/gpu_clock.h"
+#include "gl/state.h"
 
 struct NVGcontext;
 
@@ -22,8 +24,11 @@ struct RenderStats
     RenderStats(NVGcontext* vg);
 
     void accumulate(const Time& frameTime);
+    // Adds a time measured outside of the frame, such as a simulation step
+    void accumulate(const std::string& name, Duration duration);
 
-    RenderStats& operator()(float fps, const glm::ivec3& sceneSize);
+    RenderStats& operator()(float fps, const glm::ivec3& sceneSize,
+                            const gl::Counts& glCounts);
 
 private:
     struct Data;